@@ -27,38 +27,310 @@ THE SOFTWARE. */
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <utility>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <functional>
+#include <new>
+
+#if __cplusplus >= 201703L
+#  include <charconv>
+#endif
+#if defined(__cpp_lib_to_chars) && !defined(TBD_TUPLE_NO_CHARCONV)
+#  define TBD_TUPLE_HAS_CHARCONV 1
+#endif
+// constexpr for functions C++11 does not allow (several statements, setters)
+#if __cpp_constexpr >= 201304L
+#  define TBD_TUPLE_CONSTEXPR14 constexpr
+#else
+#  define TBD_TUPLE_CONSTEXPR14
+#endif
+// TBD_TUPLE_INSTRUMENT=1 counts element copies and moves, conversions, 
+// formatting and compared elements per thread (see tuple_counters). When it 
+// is off the hooks expand to the plain expressions and add no code.
+#if TBD_TUPLE_INSTRUMENT
+#  include <atomic>
+#  include <mutex>
+#  include <typeinfo>
+#  if __cpp_lib_is_constant_evaluated >= 201811L
+#    define TBD_TUPLE_COUNTER_CONSTEXPR constexpr
+#  else
+#    define TBD_TUPLE_COUNTER_CONSTEXPR
+#  endif
+#  define TBD_TUPLE_COUNT(counter) ::tbd::tuple_details::count_event(&::tbd::tuple_details::tuple_counters::counter)
+#  define TBD_TUPLE_COUNTED(counter, expr) (TBD_TUPLE_COUNT(counter), (expr))
+#  define TBD_TUPLE_TRANSFER(V, v) ::tbd::tuple_details::count_transfer<V>(v)
+#  define TBD_TUPLE_CONVERSION(To, From) ::tbd::tuple_details::count_conversion<To, From>()
+#else
+#  define TBD_TUPLE_COUNT(counter) ((void)0)
+#  define TBD_TUPLE_COUNTED(counter, expr) (expr)
+#  define TBD_TUPLE_TRANSFER(V, v) static_cast<typename std::add_rvalue_reference<V>::type>(v)
+#  define TBD_TUPLE_CONVERSION(To, From) ((void)0)
+#endif
 
 namespace tbd {
 namespace tuple_details {
 
+//////////////////////// counters
+
+#if TBD_TUPLE_INSTRUMENT
+
+// runtime conversions between one pair of element types
+struct conversion_count {
+  const std::type_info* from;
+  const std::type_info* to;
+  std::size_t count;
+};
+
+// what the tuples of one thread did since the last reset
+struct tuple_counters {
+  std::size_t copies;      // elements copied by builders, <<, >>, set and |
+  std::size_t moves;       // elements moved by the same
+  std::size_t conversions; // runtime conversions (get<T>(i), get(i, v), iterators)
+  std::size_t streams;     // conversions and formats using a stringstream (allocates)
+  std::size_t formats;     // elements written as text by join
+  std::size_t comparisons; // element pairs visited by eq, neq and compare
+  std::vector<conversion_count> by_type; // conversions per (from, to), sorted by first use
+};
+
+// receives the counters of flush_counters and of every exiting thread
+typedef void (*counters_hook)(const tuple_counters&);
+
+inline std::atomic<counters_hook>& counters_hook_ref() { 
+  static std::atomic<counters_hook> hook(nullptr); 
+  return hook; 
+}
+
+// every (from, to) pair gets a process wide id when it is converted first
+struct conversion_types {
+  static conversion_types& instance() { static conversion_types types; return types; }
+
+  std::size_t add(const std::type_info& from, const std::type_info& to) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _types.push_back(std::make_pair(&from, &to));
+    return _types.size() - 1;
+  }
+  template<class F> void each(F f) {
+    std::lock_guard<std::mutex> guard(_lock);
+    for (std::size_t i = 0; i < _types.size(); ++i) f(i, *_types[i].first, *_types[i].second);
+  }
+private:
+  std::mutex _lock;
+  std::vector<std::pair<const std::type_info*, const std::type_info*> > _types;
+};
+
+template<class To, class From> std::size_t conversion_id() {
+  static const std::size_t id = conversion_types::instance().add(typeid(From), typeid(To));
+  return id;
+}
+
+struct thread_counters : tuple_counters {
+  thread_counters(): tuple_counters() {}
+  ~thread_counters() {
+    counters_hook hook = counters_hook_ref().load();
+    if (hook && !empty()) hook(snapshot());
+  }
+
+  bool empty() const { 
+    return !(copies || moves || conversions || streams || formats || comparisons); 
+  }
+  tuple_counters snapshot() const {
+    tuple_counters s = *this;
+    conversion_types::instance().each([&](std::size_t id, const std::type_info& from, const std::type_info& to) {
+      if (id < by_id.size() && by_id[id]) {
+        conversion_count c = { &from, &to, by_id[id] };
+        s.by_type.push_back(c);
+      }
+    });
+    return s;
+  }
+  void reset() {
+    (tuple_counters&)*this = tuple_counters();
+    by_id.assign(by_id.size(), 0);
+  }
+
+  std::vector<std::size_t> by_id;
+};
+
+inline thread_counters& local_counters() { 
+  static thread_local thread_counters counters; 
+  return counters; 
+}
+
+// the hooks do not count while a constant expression is evaluated (C++20), 
+// before C++20 instrumented builders and comparisons are not constexpr
+#if __cpp_lib_is_constant_evaluated >= 201811L
+constexpr bool counting() { return !std::is_constant_evaluated(); }
+#else
+inline bool counting() { return true; }
+#endif
+
+TBD_TUPLE_COUNTER_CONSTEXPR inline void count_event(std::size_t tuple_counters::*counter) {
+  if (counting()) ++(local_counters().*counter);
+}
+
+// V is deduced as for std::forward: lvalue references are copied
+template<class V> TBD_TUPLE_COUNTER_CONSTEXPR V&& count_transfer(typename std::remove_reference<V>::type& v) {
+  count_event(std::is_lvalue_reference<V>::value ? &tuple_counters::copies : &tuple_counters::moves);
+  return static_cast<V&&>(v);
+}
+template<class V> TBD_TUPLE_COUNTER_CONSTEXPR V&& count_transfer(typename std::remove_reference<V>::type&& v) {
+  count_event(std::is_lvalue_reference<V>::value ? &tuple_counters::copies : &tuple_counters::moves);
+  return static_cast<V&&>(v);
+}
+
+template<class To, class From> inline void count_conversion() {
+  thread_counters& c = local_counters();
+  ++c.conversions;
+  std::size_t id = conversion_id<To, From>();
+  if (id >= c.by_id.size()) c.by_id.resize(id + 1);
+  ++c.by_id[id];
+}
+
+// counters of the calling thread
+inline tuple_counters counters() { return local_counters().snapshot(); }
+
+inline void reset_counters() { local_counters().reset(); }
+
+// hands the counters of the calling thread to the hook and resets them
+inline void flush_counters() {
+  thread_counters& c = local_counters();
+  counters_hook hook = counters_hook_ref().load();
+  if (hook) hook(c.snapshot());
+  c.reset();
+}
+
+// installs the hook (0 removes it) and returns the previous one
+inline counters_hook set_counters_hook(counters_hook hook) { 
+  return counters_hook_ref().exchange(hook); 
+}
+
+#endif
+
 //////////////////////// forward declaration
 
 template<class HT, class TT> struct tuple_item;
 typedef tuple_item<void, void> tuple_end;
 
-//////////////////////// meta push / pop / last / n-th element
+//////////////////////// type lists
+
+template<class... T> struct type_list { enum { size = sizeof...(T) }; };
+
+template<class T, class L> struct list_prepend;
+template<class T, class... L> struct list_prepend<T, type_list<L...> > { typedef type_list<T, L...> type; };
+
+template<class L, class T> struct list_append;
+template<class... L, class T> struct list_append<type_list<L...>, T> { typedef type_list<L..., T> type; };
+
+template<std::size_t... I> struct index_sequence {};
+
+// index_sequence<0, 1, ... N - 1> in log(N) steps
+template<class A, class B> struct join_indices;
+template<std::size_t... I, std::size_t... J> struct join_indices<index_sequence<I...>, index_sequence<J...> > {
+  typedef index_sequence<I..., (sizeof...(I) + J)...> type;
+};
+template<std::size_t N> struct make_indices {
+  typedef typename join_indices<typename make_indices<N / 2>::type, 
+    typename make_indices<N - N / 2>::type>::type type;
+};
+template<> struct make_indices<0> { typedef index_sequence<> type; };
+template<> struct make_indices<1> { typedef index_sequence<0> type; };
+
+// The C-th type of a list is picked by overload resolution: indexed_types
+// derives from indexed_type<I, T> for every element and select_type<C>
+// deduces the only base with index C - no recursion over the list.
+template<std::size_t I, class T> struct indexed_type { typedef T type; };
+template<class I, class L> struct indexed_types;
+template<std::size_t... I, class... T> struct indexed_types<index_sequence<I...>, type_list<T...> > : indexed_type<I, T>... {};
+template<std::size_t I, class T> indexed_type<I, T> select_type(const indexed_type<I, T>*);
+
+template<int C, class L> struct list_element {
+  typedef indexed_types<typename make_indices<L::size>::type, L> types;
+  typedef typename decltype(select_type<C>((types*)0))::type type;
+};
+
+//////////////////////// meta make / push / pop / last / n-th element
+
+template<class... T> struct make_tuple;
+template<> struct make_tuple<> { typedef tuple_end type; };
+template<class H, class... T> struct make_tuple<H, T...> { 
+  typedef tuple_item<H, typename make_tuple<T...>::type> type; 
+};
+
+template<class L> struct make_tuple_of;
+template<class... T> struct make_tuple_of<type_list<T...> > { typedef typename make_tuple<T...>::type type; };
+
+// the element types of a tuple_item chain
+template<class T> struct item_types {
+  typedef typename list_prepend<typename T::head_type, typename item_types<typename T::tail_type>::type>::type type;
+};
+template<> struct item_types<tuple_end> { typedef type_list<> type; };
+
+// T, its tail, the tail of its tail ... and tuple_end
+template<class T> struct item_levels {
+  typedef typename list_prepend<T, typename item_levels<typename T::tail_type>::type>::type type;
+};
+template<> struct item_levels<tuple_end> { typedef type_list<tuple_end> type; };
 
 template<class T, class E> struct push_element {
-  typedef tuple_item<typename T::head_type, typename push_element<typename T::tail_type, E>::type> type;
+  typedef typename make_tuple_of<typename list_append<typename item_types<T>::type, E>::type>::type type;
+};
+
+template<class T, class I = typename make_indices<T::size - 1>::type> struct pop_element;
+template<class T, std::size_t... I> struct pop_element<T, index_sequence<I...> > {
+  typedef typename make_tuple<typename list_element<I, typename item_types<T>::type>::type...>::type type;
 };
-template<class A> struct push_element<tuple_end, A> { typedef tuple_item<A, tuple_end> type; };
 
-template<class T> struct pop_element {
-  typedef tuple_item<typename T::head_type, typename pop_element<typename T::tail_type>::type> type;
+// the sub chain (tuple_item) whose head is element C, tuple_end for C == size
+template<int C, class T> struct tuple_element {
+  typedef typename list_element<C, typename item_levels<T>::type>::type type;
 };
-template<class HT> struct pop_element< tuple_item<HT, tuple_end> > { typedef tuple_end type; };
 
 template<class T> struct last_element {
-  typedef typename last_element<typename T::tail_type>::type type;
+  typedef typename tuple_element<T::size - 1, T>::type type;
 };
-template<class HT> struct last_element< tuple_item<HT, tuple_end> > { 
-  typedef tuple_item<HT, tuple_end> type; 
+
+//////////////////////// builder
+
+// accu << a | b | c creates a chain of builders holding references to a, b 
+// and c. Nothing is copied until the chain is converted into a tuple, then 
+// every value is copied (lvalues) or moved (rvalues) exactly once. As the 
+// builder refers to its arguments it must be consumed in the same expression.
+// Every builder derives from the builder before it and from a builder_value
+// holding its reference, so builder_element<C> finds the value of element C
+// in the base builder_value<C, V> - no walk down the chain.
+
+template<std::size_t I, class V> struct builder_value {
+  constexpr explicit builder_value(V&& v): _value(&v) {}
+  constexpr V&& value() const { return static_cast<V&&>(*_value); }
+private:
+  typename std::remove_reference<V>::type* _value;
 };
 
-template<int C, class T> struct tuple_element {
-  typedef typename tuple_element<C - 1, typename T::tail_type>::type type;
+template<std::size_t I, class V> constexpr V&& builder_element(const builder_value<I, V>& v) { 
+  return TBD_TUPLE_TRANSFER(V, v.value()); 
+}
+
+template<class P, class V> struct tuple_builder : P, builder_value<P::size, V> {
+  typedef tuple_builder<P, V> self;
+  typedef P prev_type;
+  enum { size = P::size + 1 };
+
+  constexpr tuple_builder(const P& prev, V&& value): P(prev), builder_value<P::size, V>(static_cast<V&&>(value)) {}
+
+  template<class W> constexpr tuple_builder<self, W> operator| (W&& w) const {
+    return tuple_builder<self, W>(*this, static_cast<W&&>(w));
+  }
+};
+
+struct Accumulator {
+  enum { size = 0 };
+
+  template<class V> constexpr tuple_builder<Accumulator, V> operator<< (V&& v) const {
+    return tuple_builder<Accumulator, V>(*this, static_cast<V&&>(v));
+  }
 };
-template<class T> struct tuple_element<0, T> { typedef T type; };
 
 //////////////////////// tuple_item
 
@@ -68,115 +340,177 @@ template<class HT, class TT> struct tuple_item: public TT {
   typedef HT head_type;
   typedef TT tail_type;
 
-  tuple_item() {}
+  tuple_item() = default;
+
+  // defaulted, so tuples of trivially copyable elements are trivially copyable
+  tuple_item(const self& other) = default;
+  tuple_item(self&& other) = default;
+
+  template<class OHT, class OTT> constexpr tuple_item(const tuple_item<OHT, OTT>& other): 
+    tail_type(other.tail()), _head(TBD_TUPLE_TRANSFER(const OHT&, other.head())) {}
+
+  template<class OHT, class OTT> tuple_item(tuple_item<OHT, OTT>&& other): 
+    tail_type(std::move(other.tail())), _head(TBD_TUPLE_TRANSFER(OHT, other.head())) {}
 
-  tuple_item(const tuple_item<HT, TT>& other): 
-    tail_type(other.tail()), _head(other.head()) {}
+  // every element is taken from the builder chain exactly once
+  template<class P, class V> constexpr tuple_item(const tuple_builder<P, V>& b): 
+    tail_type(b), _head(builder_element<(int)tuple_builder<P, V>::size - (int)size>(b)) {}
 
-  template<class OHT, class OTT> tuple_item(const tuple_item<OHT, OTT>& other): 
-    tail_type(other.tail()), _head(other.head()) {}
+  self& operator= (const self& other) = default;
+  self& operator= (self&& other) = default;
 
-  head_type& head() { return _head; }
-  tail_type& tail() { return *this; }
-  const head_type& head() const { return _head; }
-  const tail_type& tail() const { return *this; }
+  TBD_TUPLE_CONSTEXPR14 head_type& head() { return _head; }
+  TBD_TUPLE_CONSTEXPR14 tail_type& tail() { return *this; }
+  constexpr const head_type& head() const { return _head; }
+  constexpr const tail_type& tail() const { return *this; }
 
-  template<class V> typename push_element<self, V>::type operator| (const V& v) {
-    return typename push_element<self, V>::type(*this, v);
+  template<class V> typename push_element<self, typename std::decay<V>::type>::type operator| (V&& v) const & {
+    return typename push_element<self, typename std::decay<V>::type>::type(*this, std::forward<V>(v));
   }
+  template<class V> typename push_element<self, typename std::decay<V>::type>::type operator| (V&& v) && {
+    return typename push_element<self, typename std::decay<V>::type>::type(std::move(*this), std::forward<V>(v));
+  }
+
+  template<class OHT, class OTT, class V> explicit tuple_item(const tuple_item<OHT, OTT>& other, V&& v): 
+    tail_type(other.tail(), std::forward<V>(v)), _head(TBD_TUPLE_TRANSFER(const OHT&, other.head())) {}
 
-  template<class OHT, class OTT, class V> explicit tuple_item(const tuple_item<OHT, OTT>& other, const V& v): 
-    tail_type(other.tail(), v), _head(other.head()) {}
+  template<class OHT, class OTT, class V> explicit tuple_item(tuple_item<OHT, OTT>&& other, V&& v): 
+    tail_type(std::move(other.tail()), std::forward<V>(v)), _head(TBD_TUPLE_TRANSFER(OHT, other.head())) {}
 
 protected:
-  friend struct Accumulator;
-  template<class V> explicit tuple_item(const tuple_end&, const V& v): _head(v) {}
+  template<class V> explicit tuple_item(const tuple_end&, V&& v): _head(TBD_TUPLE_TRANSFER(V, v)) {}
+  template<class V> explicit tuple_item(tuple_end&&, V&& v): _head(TBD_TUPLE_TRANSFER(V, v)) {}
 private:
   head_type _head;
 };
 
-template<> struct tuple_item<void, void> { enum { size = 0 }; };
-
-struct Accumulator {
-  template<class V> tuple_item<V, tuple_end> operator<< (const V& v) const  {
-    return tuple_item<V, tuple_end>(tuple_end(), v);
-  }
+template<> struct tuple_item<void, void> { 
+  enum { size = 0 }; 
+  tuple_item() = default;
+  template<class P, class V> constexpr tuple_item(const tuple_builder<P, V>&) {}
 };
 
 //////////////////////// comparison
 
-template<class T1, class T2> inline bool eq(const T1& lhs, const T2& rhs) {
-  return lhs.head() == rhs.head() && eq(lhs.tail(), rhs.tail());
+template<class T1, class T2> constexpr bool eq(const T1& lhs, const T2& rhs) {
+  return TBD_TUPLE_COUNTED(comparisons, lhs.head() == rhs.head()) && eq(lhs.tail(), rhs.tail());
 }
-template<class T1> inline bool eq(const T1&, const tuple_end&) { return false; }
-template<class T2> inline bool eq(const tuple_end&, const T2&) { return false; }
-inline bool eq(const tuple_end&, const tuple_end&) { return true; }
+template<class T1> constexpr bool eq(const T1&, const tuple_end&) { return false; }
+template<class T2> constexpr bool eq(const tuple_end&, const T2&) { return false; }
+constexpr bool eq(const tuple_end&, const tuple_end&) { return true; }
 
-template<class T1, class T2> inline bool neq(const T1& lhs, const T2& rhs) {
-  return lhs.head() != rhs.head() || neq(lhs.tail(), rhs.tail());
+template<class T1, class T2> constexpr bool neq(const T1& lhs, const T2& rhs) {
+  return TBD_TUPLE_COUNTED(comparisons, lhs.head() != rhs.head()) || neq(lhs.tail(), rhs.tail());
 }
-template<class T1> inline bool neq(const T1&, const tuple_end&) { return true; }
-template<class T2> inline bool neq(const tuple_end&, const T2&) { return true; }
-inline bool neq(const tuple_end&, const tuple_end&) { return false; }
+template<class T1> constexpr bool neq(const T1&, const tuple_end&) { return true; }
+template<class T2> constexpr bool neq(const tuple_end&, const T2&) { return true; }
+constexpr bool neq(const tuple_end&, const tuple_end&) { return false; }
 
-template<class T1, class T2> inline bool lt(const T1& lhs, const T2& rhs) {
-  return lhs.head() < rhs.head() || !(rhs.head() < lhs.head()) && lt(lhs.tail(), rhs.tail());
-}
-template<class T1> inline bool lt(const T1&, const tuple_end&) { return false; }
-template<class T2> inline bool lt(const tuple_end&, const T2&) { return true; }
-inline bool lt(const tuple_end&, const tuple_end&) { return false; }
+// compare returns a negative value, zero or a positive value if lhs is less, 
+// equal or greater than rhs. Every element is visited only once.
 
-template<class T1, class T2> inline bool gt(const T1& lhs, const T2& rhs) {
-  return lhs.head() > rhs.head() || !(rhs.head() > lhs.head()) && gt(lhs.tail(), rhs.tail());
+#if __cpp_impl_three_way_comparison >= 201907L
+template<class A, class B> constexpr auto compare_values(const A& a, const B& b, int) -> decltype(a <=> b, int()) {
+  const auto c = a <=> b;
+  return c < 0 ? -1 : c > 0 ? 1 : 0;
 }
-template<class T1> inline bool gt(const T1&, const tuple_end&) { return true; }
-template<class T2> inline bool gt(const tuple_end&, const T2&) { return false; }
-inline bool gt(const tuple_end&, const tuple_end&) { return false; }
-
-template<class T1, class T2> inline bool lte(const T1& lhs, const T2& rhs) {
-  return lhs.head() <= rhs.head() && ( !(rhs.head() <= lhs.head()) || lte(lhs.tail(), rhs.tail()));
+#endif
+template<class A, class B> constexpr int compare_values(const A& a, const B& b, long) {
+  return a < b ? -1 : b < a ? 1 : 0;
+}
+template<class A, class B> constexpr int compare_values(const A& a, const B& b) {
+  return compare_values(a, b, 0);
+}
+inline int compare_values(const std::string& a, const std::string& b) { 
+  return a.compare(b); 
 }
-template<class T1> inline bool lte(const T1&, const tuple_end&) { return false; }
-template<class T2> inline bool lte(const tuple_end&, const T2&) { return true; }
-inline bool lte(const tuple_end&, const tuple_end&) { return true; }
 
-template<class T1, class T2> inline bool gte(const T1& lhs, const T2& rhs) {
-  return lhs.head() >= rhs.head() && ( !(rhs.head() >= lhs.head()) || gte(lhs.tail(), rhs.tail()));
+template<class T1> constexpr int compare(const T1&, const tuple_end&) { return 1; }
+template<class T2> constexpr int compare(const tuple_end&, const T2&) { return -1; }
+constexpr int compare(const tuple_end&, const tuple_end&) { return 0; }
+
+// the tails are only compared if the heads are equal (c == 0)
+template<class T1, class T2> constexpr int compare_tails(int c, const T1& lhs, const T2& rhs) {
+  return c ? c : compare(lhs, rhs);
+}
+template<class T1, class T2> constexpr int compare(const T1& lhs, const T2& rhs) {
+  return compare_tails(TBD_TUPLE_COUNTED(comparisons, compare_values(lhs.head(), rhs.head())), lhs.tail(), rhs.tail());
 }
-template<class T1> inline bool gte(const T1&, const tuple_end&) { return true; }
-template<class T2> inline bool gte(const tuple_end&, const T2&) { return false; }
-inline bool gte(const tuple_end&, const tuple_end&) { return true; }
 
-template<class LHT, class LTT, class RHT, class RTT> inline
+template<class T1, class T2> constexpr bool lt(const T1& lhs, const T2& rhs) { return compare(lhs, rhs) < 0; }
+template<class T1, class T2> constexpr bool gt(const T1& lhs, const T2& rhs) { return compare(lhs, rhs) > 0; }
+template<class T1, class T2> constexpr bool lte(const T1& lhs, const T2& rhs) { return compare(lhs, rhs) <= 0; }
+template<class T1, class T2> constexpr bool gte(const T1& lhs, const T2& rhs) { return compare(lhs, rhs) >= 0; }
+
+template<class LHT, class LTT, class RHT, class RTT> constexpr
 bool operator==(const tuple_item<LHT, LTT>& l, const tuple_item<RHT, RTT>& r) { return eq(l, r); }
 
-template<class LHT, class LTT, class RHT, class RTT> inline
+template<class LHT, class LTT, class RHT, class RTT> constexpr
 bool operator!=(const tuple_item<LHT, LTT>& l, const tuple_item<RHT, RTT>& r) { return neq(l, r); }
 
-template<class LHT, class LTT, class RHT, class RTT> inline
+template<class LHT, class LTT, class RHT, class RTT> constexpr
 bool operator< (const tuple_item<LHT, LTT>& l, const tuple_item<RHT, RTT>& r) { return lt(l, r); }
 
-template<class LHT, class LTT, class RHT, class RTT> inline
+template<class LHT, class LTT, class RHT, class RTT> constexpr
 bool operator> (const tuple_item<LHT, LTT>& l, const tuple_item<RHT, RTT>& r) { return gt(l, r); }
 
-template<class LHT, class LTT, class RHT, class RTT> inline
+template<class LHT, class LTT, class RHT, class RTT> constexpr
 bool operator<=(const tuple_item<LHT, LTT>& l, const tuple_item<RHT, RTT>& r) { return lte(l, r); }
 
-template<class LHT, class LTT, class RHT, class RTT> inline
+template<class LHT, class LTT, class RHT, class RTT> constexpr
 bool operator>=(const tuple_item<LHT, LTT>& l, const tuple_item<RHT, RTT>& r) { return gte(l, r); }
 
+//////////////////////// hash
+
+// hash combines the std::hash of every element with a 64 bit finalizer 
+// (murmur3), so the result is usable for power of two tables even if 
+// std::hash is the identity (as for ints).
+
+inline std::uint64_t mix_hash(std::uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+template<class V> inline std::size_t hash_value(const V& v) { return std::hash<V>()(v); }
+template<class HT, class TT> inline std::size_t hash_value(const tuple_item<HT, TT>& t);
+
+inline std::uint64_t hash(const tuple_end&, std::uint64_t seed) { return seed; }
+template<class T> inline std::uint64_t hash(const T& tuple, std::uint64_t seed) {
+  return hash(tuple.tail(), mix_hash(seed + 0x9e3779b97f4a7c15ULL + hash_value(tuple.head())));
+}
+template<class T> inline std::size_t hash(const T& tuple) { 
+  return (std::size_t)hash(tuple, (std::uint64_t)T::size); 
+}
+
+template<class HT, class TT> inline std::size_t hash_value(const tuple_item<HT, TT>& t) { 
+  return hash(t); 
+}
+
+struct tuple_hash {
+  template<class T> std::size_t operator()(const T& tuple) const { return hash(tuple); }
+};
+
 //////////////////////// get /set
 
-template<int C, class HT, class TT> inline typename tuple_element<C, 
+template<int C, class HT, class TT> TBD_TUPLE_CONSTEXPR14 typename tuple_element<C, 
   tuple_item<HT, TT> >::type::head_type& tuple_get(tuple_item<HT, TT>& r) {
-typedef typename tuple_element<C, tuple_item<HT, TT> >::type te;
+  typedef typename tuple_element<C, tuple_item<HT, TT> >::type te;
   return ((te&)r).head();
 }
+template<int C, class HT, class TT> constexpr const typename tuple_element<C, 
+  tuple_item<HT, TT> >::type::head_type& tuple_get(const tuple_item<HT, TT>& r) {
+  typedef typename tuple_element<C, tuple_item<HT, TT> >::type te;
+  return ((const te&)r).head();
+}
 
-template<int C, class HT, class TT> inline void tuple_set(tuple_item<HT, TT>& r, 
+template<int C, class HT, class TT> TBD_TUPLE_CONSTEXPR14 void tuple_set(tuple_item<HT, TT>& r, 
   const typename tuple_element<C, tuple_item<HT, TT> >::type::head_type& value) {
   typedef typename tuple_element<C, tuple_item<HT, TT> >::type te;
-  ((te&)r).head() = value;
+  ((te&)r).head() = TBD_TUPLE_TRANSFER(const typename te::head_type&, value);
 }
 
 //////////////////////// accessor
@@ -201,22 +535,45 @@ protected:
 
 //////////////////////// accept
 
-template<class V> void tuple_accept(tuple_end&, V&, int i = 0) {}
-template<class V> void tuple_accept(const tuple_end&, V&, int i = 0) {}
-template<class T, class V> V& tuple_accept(T& tuple, V& visitor, int i = 0) {
+template<class V> TBD_TUPLE_CONSTEXPR14 void tuple_accept(tuple_end&, V&, int i = 0) {}
+template<class V> TBD_TUPLE_CONSTEXPR14 void tuple_accept(const tuple_end&, V&, int i = 0) {}
+template<class T, class V> TBD_TUPLE_CONSTEXPR14 V& tuple_accept(T& tuple, V& visitor, int i = 0) {
   visitor(tuple.head(), i);
   tuple_accept(tuple.tail(), visitor, i + 1);
   return visitor;
 }
 
-template<class V> void tuple_accept(tuple_end&, const V&, int i = 0) {}
-template<class V> void tuple_accept(const tuple_end&, const V&, int i = 0) {}
-template<class T, class V> const V& tuple_accept(T& tuple, const V& visitor, int i = 0) {
+template<class V> TBD_TUPLE_CONSTEXPR14 void tuple_accept(tuple_end&, const V&, int i = 0) {}
+template<class V> TBD_TUPLE_CONSTEXPR14 void tuple_accept(const tuple_end&, const V&, int i = 0) {}
+template<class T, class V> TBD_TUPLE_CONSTEXPR14 const V& tuple_accept(T& tuple, const V& visitor, int i = 0) {
   visitor(tuple.head(), i);
   tuple_accept(tuple.tail(), visitor, i + 1);
   return visitor;
 }
 
+//////////////////////// visit
+
+// Like accept but the index is passed as std::integral_constant<std::size_t, I>,
+// so visitors can overload (or specialize) on the element at compile time.
+
+template<class V, std::size_t I> TBD_TUPLE_CONSTEXPR14 void tuple_visit(tuple_end&, V&, std::integral_constant<std::size_t, I>) {}
+template<class V, std::size_t I> TBD_TUPLE_CONSTEXPR14 void tuple_visit(const tuple_end&, V&, std::integral_constant<std::size_t, I>) {}
+template<class T, class V, std::size_t I = 0> TBD_TUPLE_CONSTEXPR14 
+V& tuple_visit(T& tuple, V& visitor, std::integral_constant<std::size_t, I> i = std::integral_constant<std::size_t, I>()) {
+  visitor(tuple.head(), i);
+  tuple_visit(tuple.tail(), visitor, std::integral_constant<std::size_t, I + 1>());
+  return visitor;
+}
+
+template<class V, std::size_t I> TBD_TUPLE_CONSTEXPR14 void tuple_visit(tuple_end&, const V&, std::integral_constant<std::size_t, I>) {}
+template<class V, std::size_t I> TBD_TUPLE_CONSTEXPR14 void tuple_visit(const tuple_end&, const V&, std::integral_constant<std::size_t, I>) {}
+template<class T, class V, std::size_t I = 0> TBD_TUPLE_CONSTEXPR14 
+const V& tuple_visit(T& tuple, const V& visitor, std::integral_constant<std::size_t, I> i = std::integral_constant<std::size_t, I>()) {
+  visitor(tuple.head(), i);
+  tuple_visit(tuple.tail(), visitor, std::integral_constant<std::size_t, I + 1>());
+  return visitor;
+}
+
 //////////////////////// ignore
 
 struct ignore {};
@@ -225,25 +582,25 @@ struct ignore {};
 
 template<class T, class S = T> struct collector : public collector<T, typename S::tail_type> {
   typedef collector<T, typename S::tail_type> super;
-  collector(T& r): super(r) {}
+  constexpr collector(T& r): super(r) {}
 
-  template<class V> super& operator| (const V& v) { 
-    ((S&)(T&)*this).head() = v; 
+  template<class V> TBD_TUPLE_CONSTEXPR14 super& operator| (V&& v) { 
+    ((S&)(T&)*this).head() = TBD_TUPLE_TRANSFER(V, v); 
     return *this; 
   }
-  super& operator| (const ignore&) { return *this; }
+  TBD_TUPLE_CONSTEXPR14 super& operator| (const ignore&) { return *this; }
 };
 
 template<class T> struct collector<T, tuple_end> {
-  collector(T& t): _tuple(t) {}
-  operator T& () { return _tuple; }
+  constexpr collector(T& t): _tuple(t) {}
+  TBD_TUPLE_CONSTEXPR14 operator T& () { return _tuple; }
 protected:
   T& _tuple;
 };
 
-template<class HT, class TT, class V> 
-collector<tuple_item<HT, TT>, TT> operator<< (tuple_item<HT, TT>& tuple, const V& value) {
-  return collector< tuple_item<HT, TT> >(tuple) | value;
+template<class HT, class TT, class V> TBD_TUPLE_CONSTEXPR14
+collector<tuple_item<HT, TT>, TT> operator<< (tuple_item<HT, TT>& tuple, V&& value) {
+  return collector< tuple_item<HT, TT> >(tuple) | std::forward<V>(value);
 }
 
 //////////////////////// distributor
@@ -253,7 +610,7 @@ template<class T, class S = T> struct distributor : public distributor<T, typena
   distributor(T& r): super(r) {}
 
   template<class V> super& operator| (V& t) { 
-    t = (V&)((S&)(T&)*this).head(); 
+    t = TBD_TUPLE_TRANSFER(const typename S::head_type&, ((S&)(T&)*this).head()); 
     return *this; 
   }
   super& operator| (const ignore&) { return *this; }
@@ -271,70 +628,231 @@ distributor<tuple_item<HT, TT>, TT> operator>> (tuple_item<HT, TT>& tuple, V& va
   return distributor< tuple_item<HT, TT> >(tuple) | value;
 }
 
-//////////////////////// join
+//////////////////////// converter
 
-struct joiner {
-  joiner(std::string separator): _sep(separator) {}
-  template<class T> void operator() (const T& value, int i) {
-    if (i) _sstr << _sep;
-    _sstr << value;
-  }
-  std::string str() { return _sstr.str(); }
-private:
-  std::stringstream _sstr;
-  std::string _sep;
-};
+// numbers are arithmetic types that are written as digits (not bool or chars)
 
-//////////////////////// converter
+template<class T> struct is_number : std::integral_constant<bool, 
+  std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value && 
+  !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value && 
+  !std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value> {};
 
-template<class Tuple, class To, class Sub> struct convert {
-  static To do_it(const Tuple& t) {
-    To value;
+#if TBD_TUPLE_HAS_CHARCONV
+
+// writes value to [first, last) and returns the end of the written text or 0 
+// if it does not fit. Floating point values are written with the shortest 
+// representation that reads back to the same value.
+template<class V> inline char* format_number(char* first, char* last, V value) {
+  std::to_chars_result r = std::to_chars(first, last, value);
+  return r.ec == std::errc() ? r.ptr : 0;
+}
+
+// reads a number from [first, last) like operator>> would (leading spaces and 
+// a plus sign are skipped, parsing stops at the first invalid character)
+template<class V> inline bool parse_number(const char* first, const char* last, V& value) {
+  while (first != last && (*first == ' ' || *first == '\t' || *first == '\n' || *first == '\r')) ++first;
+  if (first != last && *first == '+') ++first;
+  return std::from_chars(first, last, value).ec == std::errc();
+}
+
+#endif
+
+// converts between element types. Numbers are cast directly and formatted or 
+// parsed with <charconv> - no stream, no locale and no heap allocation. All 
+// other combinations fall back to a stringstream.
+
+template<class To, class From, class = void> struct value_converter {
+  static To do_it(const From& v) {
+    TBD_TUPLE_COUNT(streams);
+    To value = To();
     std::stringstream _sstr;
     _sstr.precision(15);
-    _sstr << ((Sub&)t).head();
+    _sstr << v;
     _sstr >> value;
     return value;
   }
 };
+
+template<class To, class From> struct value_converter<To, From, 
+  typename std::enable_if<std::is_arithmetic<To>::value && std::is_arithmetic<From>::value>::type> {
+  static To do_it(const From& v) { return static_cast<To>(v); }
+};
+
+#if TBD_TUPLE_HAS_CHARCONV
+
+template<class From> struct value_converter<std::string, From, 
+  typename std::enable_if<is_number<From>::value>::type> {
+  static std::string do_it(const From& v) {
+    char buffer[64];
+    return std::string(buffer, format_number(buffer, buffer + sizeof(buffer), v));
+  }
+};
+
+template<class To> struct value_converter<To, std::string, 
+  typename std::enable_if<is_number<To>::value>::type> {
+  static To do_it(const std::string& v) {
+    To value = To();
+    parse_number(v.data(), v.data() + v.size(), value);
+    return value;
+  }
+};
+
+template<class To> struct value_converter<To, const char*, 
+  typename std::enable_if<is_number<To>::value>::type> {
+  static To do_it(const char* v) {
+    To value = To();
+    if (v) parse_number(v, v + std::strlen(v), value);
+    return value;
+  }
+};
+template<class To> struct value_converter<To, char*, 
+  typename std::enable_if<is_number<To>::value>::type> : value_converter<To, const char*> {};
+
+#endif
+
+template<class To, class From> inline To convert_value(const From& v) {
+  TBD_TUPLE_CONVERSION(To, From);
+  return value_converter<To, From>::do_it(v);
+}
+
+template<class Tuple, class To, class Sub> struct convert {
+  static To do_it(const Tuple& t) {
+    return convert_value<To>(((Sub&)t).head());
+  }
+};
 template<class Tuple, class Sub> struct convert<Tuple, typename Sub::head_type, Sub> {
   static typename Sub::head_type do_it(const Tuple& t) { return ((Sub&)t).head(); }
 };
 
-template<class TT, class VT, class T> struct create_func_table {
-    typedef VT(*pt_convert)(const TT&);
-  static void create(pt_convert* ft) {
-    *ft = convert<TT, VT, T>::do_it;
-    create_func_table<TT, VT, typename T::tail_type>::create(++ft);
+// get(tuple, i) expands to a chain of index checks (the compiler turns it 
+// into a jump table or inlines it). There is no table to set up at runtime, 
+// so concurrent first calls are safe.
+
+template<class TT, class VT, class T> struct convert_at {
+  static VT get(const TT& tuple, int i) {
+    return i ? convert_at<TT, VT, typename T::tail_type>::get(tuple, i - 1) : convert<TT, VT, T>::do_it(tuple);
   }
 };
-template<class TT, class VT> struct create_func_table<TT, VT, tuple_end> {
-    typedef VT(*pt_convert)(const TT&);
-  static void create(pt_convert*) {}
-};
-template<class TT, class VT> struct create_func_table<TT, VT, const tuple_end> {
-  typedef VT(*pt_convert)(const TT&);
-  static void create(pt_convert*) {}
+template<class TT, class VT> struct convert_at<TT, VT, tuple_end> {
+  static VT get(const TT&, int) { return VT(); }
 };
 
 template<class TT, class VT> struct converter {
   static VT get(const TT& tuple, int i) {
-    if (i >= TT::size) return VT();
-    return func_table()[i](tuple);
+    if (i < 0 || i >= TT::size) return VT();
+    return convert_at<TT, VT, TT>::get(tuple, i);
   }
 private:
-  typedef VT(*pt_convert)(const TT&);
   converter(); // no instances
+};
+
+//////////////////////// join
+
+// format of a single element for join_to: 0 writes the shortest representation, 
+// 'f' fixed, 'e' scientific, 'g' general (all with the given precision) and 
+// 'x' writes integers as hex
+struct field_format {
+  field_format(char format = 0, int precision = -1): format(format), precision(precision) {}
+  char format;
+  int precision;
+};
 
-  static pt_convert* func_table() {
-    static pt_convert ft[TT::size] = {0};
-    if (!ft[0]) create_func_table<TT, VT, TT>::create(ft);
-    return ft;
+#if TBD_TUPLE_HAS_CHARCONV
+
+template<class V> inline char* format_number(char* first, char* last, V value, const field_format& f, std::false_type) {
+  if (!f.format) return format_number(first, last, value);
+  std::chars_format cf = f.format == 'f' ? std::chars_format::fixed : f.format == 'e' ? std::chars_format::scientific : 
+    f.format == 'x' ? std::chars_format::hex : std::chars_format::general;
+  std::to_chars_result r = f.precision < 0 ? std::to_chars(first, last, value, cf) : std::to_chars(first, last, value, cf, f.precision);
+  return r.ec == std::errc() ? r.ptr : 0;
+}
+template<class V> inline char* format_number(char* first, char* last, V value, const field_format& f, std::true_type) {
+  std::to_chars_result r = std::to_chars(first, last, value, f.format == 'x' ? 16 : 10);
+  return r.ec == std::errc() ? r.ptr : 0;
+}
+
+#endif
+
+template<class Sink, class V> inline void write_text(Sink& out, const V& value, const field_format& f, std::false_type) {
+  TBD_TUPLE_COUNT(streams);
+  std::ostringstream _sstr;
+  if (f.precision >= 0) _sstr.precision(f.precision);
+  if (f.format == 'f') _sstr << std::fixed;
+  else if (f.format == 'e') _sstr << std::scientific;
+  else if (f.format == 'x') _sstr << std::hex;
+  _sstr << value;
+  const std::string& text = _sstr.str();
+  out.append(text.data(), text.size());
+}
+template<class Sink, class V> inline void write_text(Sink& out, const V& value, const field_format& f, std::true_type) {
+#if TBD_TUPLE_HAS_CHARCONV
+  char buffer[128];
+  if (char* end = format_number(buffer, buffer + sizeof(buffer), value, f, std::is_integral<V>())) {
+    out.append(buffer, end - buffer);
+    return;
   }
+#endif
+  write_text(out, value, f, std::false_type());
+}
+
+// writes value as operator<< would, numbers are written without a stream
+template<class Sink, class V> inline void write_text(Sink& out, const V& value, const field_format& f) {
+  write_text(out, value, f, is_number<V>());
+}
+template<class Sink> inline void write_text(Sink& out, const std::string& value, const field_format&) {
+  out.append(value.data(), value.size());
+}
+template<class Sink> inline void write_text(Sink& out, const char* value, const field_format&) {
+  out.append(value, std::strlen(value));
+}
+template<class Sink> inline void write_text(Sink& out, char value, const field_format&) {
+  out.append(&value, 1);
+}
+template<class Sink> inline void write_text(Sink& out, bool value, const field_format&) {
+  out.append(value ? "1" : "0", 1);
+}
+
+// sink writing to a fixed size buffer, end() is 0 if the text did not fit
+struct char_buffer {
+  char_buffer(char* first, std::size_t capacity): _pos(first), _last(first + capacity), _overflow(false) {}
+  char_buffer& append(const char* s, std::size_t n) {
+    if (_overflow || n > std::size_t(_last - _pos)) _overflow = true;
+    else { std::memcpy(_pos, s, n); _pos += n; }
+    return *this;
+  }
+  char* end() const { return _overflow ? 0 : _pos; }
+private:
+  char* _pos;
+  char* _last;
+  bool _overflow;
+};
+
+// appends all elements to a sink (anything with append(const char*, size_t)
+// like std::string, char_buffer or text_writer)
+template<class Sink> struct joiner {
+  joiner(Sink& out, const char* separator, const field_format* formats): 
+    _out(out), _sep(separator), _sep_size(std::strlen(separator)), _formats(formats) {}
+  // the separator goes before every element but the first - decided at compile time
+  template<class T> void operator() (const T& value, std::integral_constant<std::size_t, 0>) {
+    TBD_TUPLE_COUNT(formats);
+    write_text(_out, value, _formats ? _formats[0] : field_format());
+  }
+  template<class T, std::size_t I> void operator() (const T& value, std::integral_constant<std::size_t, I>) {
+    TBD_TUPLE_COUNT(formats);
+    _out.append(_sep, _sep_size);
+    write_text(_out, value, _formats ? _formats[I] : field_format());
+  }
+private:
+  Sink& _out;
+  const char* _sep;
+  std::size_t _sep_size;
+  const field_format* _formats;
 };
 
 //////////////////////// iterator
 
+// the input iterator begin<V>() returned before element_iterator, it 
+// converts eagerly on construction and on every increment
 template<class T, class V> struct iterator {
   typedef T tuple_type;
   typedef iterator<T, V> self;
@@ -343,7 +861,7 @@ template<class T, class V> struct iterator {
   typedef value_type* pointer;
   typedef std::input_iterator_tag iterator_category;
   typedef int difference_type;
-  typedef converter<tuple_type, value_type> converter;
+  typedef tuple_details::converter<tuple_type, value_type> converter;
 
   iterator(tuple_type& tuple, int pos = 0): _pos(pos), _value(), _tuple(tuple) { 
     ++(*this); 
@@ -370,65 +888,143 @@ private:
   tuple_type& _tuple;
 };
 
-//////////////////////// tuple
-
-#if !TBD_TUPLE_MAX_SIZE
-#  define TBD_TUPLE_MAX_SIZE 10
-
-#  define TBD_TUPLE_ENUM_PARAMS(param) \
-  param##0, param##1, param##2, param##3, param##4, \
-  param##5, param##6, param##7, param##8, param##9 
+//////////////////////// element_iterator
 
-#  define TBD_TUPLE_ENUM_PARAMS_WITH_DEFAULTS(param, def) \
-  param##0##def, param##1##def, param##2##def, param##3##def, param##4##def, \
-  param##5##def, param##6##def, param##7##def, param##8##def, param##9##def 
+template<class T, class V> struct all_elements_are : std::integral_constant<bool, 
+  std::is_same<typename T::head_type, V>::value && all_elements_are<typename T::tail_type, V>::value> {};
+template<class V> struct all_elements_are<tuple_end, V> : std::true_type {};
 
-#  define TBD_TUPLE_MAKE_TUPLE >::t>::t>::t>::t>::t>::t>::t>::t>::t>::t
+// reference R to element i, a chain of index checks like convert_at
+template<class T, class R, bool Last = T::size == 1> struct element_at {
+  template<class Tuple> static R get(Tuple& tuple, int i) {
+    return i ? element_at<typename T::tail_type, R>::get(tuple.tail(), i - 1) : tuple.head();
+  }
+};
+template<class T, class R> struct element_at<T, R, true> {
+  template<class Tuple> static R get(Tuple& tuple, int) { return tuple.head(); }
+};
 
-#else
-#  include <boost/preprocessor/repetition.hpp>
+// operator-> of iterators yielding values
+template<class V> struct arrow_value {
+  V value;
+  const V* operator->() const { return &value; }
+};
 
-#  define TBD_TUPLE_ENUM_PARAMS(param) \
-  BOOST_PP_ENUM_PARAMS(TBD_TUPLE_MAX_SIZE, param)
+// elements of another type are converted on every dereference
+template<class T, class V, bool Same = all_elements_are<typename std::remove_const<T>::type, V>::value> 
+struct element_access {
+  typedef V reference;
+  typedef arrow_value<V> pointer;
+  static reference get(T& tuple, int i) { 
+    return convert_at<typename std::remove_const<T>::type, V, typename std::remove_const<T>::type>::get(tuple, i); 
+  }
+  static pointer arrow(T& tuple, int i) { 
+    pointer p = { get(tuple, i) }; 
+    return p; 
+  }
+};
 
-#  define TBD_TUPLE_ENUM_PARAMS_WITH_DEFAULTS(param, def) \
-  BOOST_PP_ENUM_BINARY_PARAMS(TBD_TUPLE_MAX_SIZE, param, def BOOST_PP_INTERCEPT)
+// tuples of V only are iterated by reference
+template<class T, class V> struct element_access<T, V, true> {
+  typedef typename std::conditional<std::is_const<T>::value, const V&, V&>::type reference;
+  typedef typename std::remove_reference<reference>::type* pointer;
+  static reference get(T& tuple, int i) { 
+    return element_at<typename std::remove_const<T>::type, reference>::get(tuple, i); 
+  }
+  static pointer arrow(T& tuple, int i) { return &get(tuple, i); }
+};
 
-#  define TBD_TUPLE_MAKE_TUPLE_PART(z, n, unused) >::t
-#  define TBD_TUPLE_MAKE_TUPLE \
-  BOOST_PP_REPEAT(TBD_TUPLE_MAX_SIZE, TBD_TUPLE_MAKE_TUPLE_PART, ~)
+// An iterator over the elements of a tuple as V. Nothing is converted until
+// it is dereferenced, so end() and skipped elements cost nothing. If every 
+// element is a V it yields references (const ones for a const tuple) and is
+// a random access iterator. Otherwise it yields converted values, which makes
+// it an input iterator for the standard library (forward iterators need 
+// references) even though it moves around like a random access one, as the 
+// iterator_concept of C++20 says.
+template<class T, class V> struct element_iterator {
+  typedef element_iterator<T, V> self;
+  typedef element_access<T, V> access;
+  typedef T tuple_type;
+  typedef V value_type;
+  typedef typename access::reference reference;
+  typedef typename access::pointer pointer;
+  typedef typename std::conditional<std::is_reference<reference>::value, 
+    std::random_access_iterator_tag, std::input_iterator_tag>::type iterator_category;
+  typedef std::random_access_iterator_tag iterator_concept;
+  typedef std::ptrdiff_t difference_type;
+
+  element_iterator(): _tuple(0), _pos(0) {}
+  explicit element_iterator(tuple_type& tuple, int pos = 0): _tuple(&tuple), _pos(pos) {}
+
+  // a mutable iterator converts to the const variant
+  template<class U> element_iterator(const element_iterator<U, V>& other, 
+    typename std::enable_if<std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type* = 0): 
+    _tuple(other.source()), _pos(other.position()) {}
+
+  reference operator*() const { return access::get(*_tuple, _pos); }
+  pointer operator->() const { return access::arrow(*_tuple, _pos); }
+  reference operator[](difference_type n) const { return access::get(*_tuple, _pos + int(n)); }
+
+  self& operator++() { ++_pos; return *this; }
+  self& operator--() { --_pos; return *this; }
+  self operator++(int) { self i(*this); ++_pos; return i; }
+  self operator--(int) { self i(*this); --_pos; return i; }
+  self& operator+=(difference_type n) { _pos += int(n); return *this; }
+  self& operator-=(difference_type n) { _pos -= int(n); return *this; }
+  self operator+(difference_type n) const { return self(*this) += n; }
+  self operator-(difference_type n) const { return self(*this) -= n; }
+  friend self operator+(difference_type n, const self& i) { return i + n; }
+  difference_type operator-(const self& other) const { return _pos - other._pos; }
+
+  bool operator==(const self& other) const { return _pos == other._pos && _tuple == other._tuple; }
+  bool operator!=(const self& other) const { return !(*this == other); }
+  bool operator<(const self& other) const { return _pos < other._pos; }
+  bool operator>(const self& other) const { return _pos > other._pos; }
+  bool operator<=(const self& other) const { return _pos <= other._pos; }
+  bool operator>=(const self& other) const { return _pos >= other._pos; }
+
+  tuple_type* source() const { return _tuple; }
+  int position() const { return _pos; }
 
-#endif
+private:
+  tuple_type* _tuple;
+  int _pos;
+};
 
-template<class T1, class T2> struct mt { typedef tuple_item<T1, T2> t; };
-template<class T1> struct mt<T1, void> { typedef tuple_item<T1, tuple_end> t; };
-template<> struct mt<void, void> { typedef void t; };
+//////////////////////// tuple
 
-template<TBD_TUPLE_ENUM_PARAMS(class T)> struct make_tuple { 
-  typedef TBD_TUPLE_ENUM_PARAMS(typename mt<T), void TBD_TUPLE_MAKE_TUPLE type;
-};
+template<class... S> 
+struct tuple : make_tuple<S...>::type  { 
+  typedef tuple<S...> self;
+  typedef typename make_tuple<S...>::type value_type;
 
-template<TBD_TUPLE_ENUM_PARAMS_WITH_DEFAULTS(class S, = void)> 
-struct tuple : make_tuple<TBD_TUPLE_ENUM_PARAMS(S)>::type  { 
-  typedef tuple<TBD_TUPLE_ENUM_PARAMS(S)> self;
-  typedef typename make_tuple<TBD_TUPLE_ENUM_PARAMS(S)>::type value_type;
+  tuple() = default;
+  tuple(const self& t) = default;
+  tuple(self&& t) = default;
 
-  tuple() {}
-  tuple(const self& t): value_type(t.value()) {}
+  template<class HT, class TT> constexpr tuple(const tuple_item<HT, TT>& t): value_type(t) {}
+  template<class HT, class TT> tuple(tuple_item<HT, TT>&& t): value_type(std::move(t)) {}
+  template<class P, class V> constexpr tuple(const tuple_builder<P, V>& b): value_type(b) {
+    static_assert((int)tuple_builder<P, V>::size == (int)value_type::size, "accu << ... needs one value per element");
+  }
 
-  template<class HT, class TT> tuple(const tuple_item<HT, TT>& t): value_type(t) {}
+  self& operator= (const self& t) = default;
+  self& operator= (self&& t) = default;
 
   template<int C> struct element { 
     typedef typename tuple_element<C, value_type>::type::head_type type; 
   };
 
-  template<int C> typename element<C>::type& get() { 
+  template<int C> TBD_TUPLE_CONSTEXPR14 typename element<C>::type& get() { 
+    return tuple_get<C>(value()); 
+  }
+  template<int C> constexpr const typename element<C>::type& get() const { 
     return tuple_get<C>(value()); 
   }
   template<class T> T get(int i) {
     return converter<value_type, T>::get(value(), i);
   }
-  template<int C> void set(const typename element<C>::type& v) { 
+  template<int C> TBD_TUPLE_CONSTEXPR14 void set(const typename element<C>::type& v) { 
     return tuple_set<C>(value(), v); 
   }
   typename value_type::head_type& first() { 
@@ -437,11 +1033,17 @@ struct tuple : make_tuple<TBD_TUPLE_ENUM_PARAMS(S)>::type  {
   typename last_element<value_type>::type::head_type& last() { 
     return tuple_get<value_type::size - 1>(value()); 
   }
-  template<class V> iterator<value_type, V> begin() {
-    return iterator<value_type, V>(value());
+  template<class V> element_iterator<value_type, V> begin() {
+    return element_iterator<value_type, V>(value());
+  }
+  template<class V> element_iterator<value_type, V> end() {
+    return element_iterator<value_type, V>(value(), value_type::size);
   }
-  template<class V> iterator<value_type, V> end() {
-    return iterator<value_type, V>(value(), value_type::size);
+  template<class V> element_iterator<const value_type, V> begin() const {
+    return element_iterator<const value_type, V>(value());
+  }
+  template<class V> element_iterator<const value_type, V> end() const {
+    return element_iterator<const value_type, V>(value(), value_type::size);
   }
 
   template<int C> struct accessor : tuple_accessor<C, value_type> { 
@@ -453,9 +1055,9 @@ struct tuple : make_tuple<TBD_TUPLE_ENUM_PARAMS(S)>::type  {
     }
   };
 
-  template<class V> 
-  collector<self, typename value_type::tail_type> operator<< (const V& value) {
-    return collector<self, value_type>(*this) | value;
+  template<class V> TBD_TUPLE_CONSTEXPR14
+  collector<self, typename value_type::tail_type> operator<< (V&& value) {
+    return collector<self, value_type>(*this) | std::forward<V>(value);
   }
 
   template<class V> 
@@ -463,53 +1065,148 @@ struct tuple : make_tuple<TBD_TUPLE_ENUM_PARAMS(S)>::type  {
     return distributor<self, value_type>(*this) | value;
   }
 
-  template<class V> V& accept(V& visitor) { 
+  template<class V> TBD_TUPLE_CONSTEXPR14 V& accept(V& visitor) { 
+    return tuple_accept(value(), visitor); 
+  }
+  template<class V> TBD_TUPLE_CONSTEXPR14 const V& accept(const V& visitor) { 
     return tuple_accept(value(), visitor); 
   }
-  template<class V> const V& accept(const V& visitor) { 
+  template<class V> TBD_TUPLE_CONSTEXPR14 V& accept(V& visitor) const { 
     return tuple_accept(value(), visitor); 
   }
+  template<class V> TBD_TUPLE_CONSTEXPR14 const V& accept(const V& visitor) const { 
+    return tuple_accept(value(), visitor); 
+  }
+
+  // visitor(element, std::integral_constant<std::size_t, I>()) for every element
+  template<class V> TBD_TUPLE_CONSTEXPR14 V& visit(V& visitor) { 
+    return tuple_visit(value(), visitor); 
+  }
+  template<class V> TBD_TUPLE_CONSTEXPR14 const V& visit(const V& visitor) { 
+    return tuple_visit(value(), visitor); 
+  }
+  template<class V> TBD_TUPLE_CONSTEXPR14 V& visit(V& visitor) const { 
+    return tuple_visit(value(), visitor); 
+  }
+  template<class V> TBD_TUPLE_CONSTEXPR14 const V& visit(const V& visitor) const { 
+    return tuple_visit(value(), visitor); 
+  }
   
-  std::string join(std::string separator = "") {
-    joiner visitor(separator);
-    return accept(visitor).str();
+  std::string join(std::string separator = "") const {
+    std::string out;
+    return join_to(out, separator.c_str());
+  }
+
+  // appends the elements to out, formats (if given) holds one entry per element
+  template<class Sink> Sink& join_to(Sink& out, const char* separator = "", const field_format* formats = 0) const {
+    joiner<Sink> visitor(out, separator, formats);
+    tuple_visit(value(), visitor);
+    return out;
+  }
+  // returns the end of the written text or 0 if it did not fit
+  char* join_to(char* buffer, std::size_t capacity, const char* separator = "", const field_format* formats = 0) const {
+    char_buffer out(buffer, capacity);
+    return join_to(out, separator, formats).end();
   }
 
-  template<TBD_TUPLE_ENUM_PARAMS(class T)> 
-  bool operator==(const tuple<TBD_TUPLE_ENUM_PARAMS(T)>& r) { 
+  template<class... T> 
+  constexpr bool operator==(const tuple<T...>& r) const { 
     return eq(value(), r.value()); 
   }
-  template<TBD_TUPLE_ENUM_PARAMS(class T)> 
-  bool operator!=(const tuple<TBD_TUPLE_ENUM_PARAMS(T)>& r) { 
+  template<class... T> 
+  constexpr bool operator!=(const tuple<T...>& r) const { 
     return neq(value(), r.value()); 
   }
-  template<TBD_TUPLE_ENUM_PARAMS(class T)> 
-  bool operator< (const tuple<TBD_TUPLE_ENUM_PARAMS(T)>& r) { 
+  template<class... T> 
+  constexpr bool operator< (const tuple<T...>& r) const { 
     return lt(value(), r.value()); 
   }
-  template<TBD_TUPLE_ENUM_PARAMS(class T)> 
-  bool operator> (const tuple<TBD_TUPLE_ENUM_PARAMS(T)>& r) { 
+  template<class... T> 
+  constexpr bool operator> (const tuple<T...>& r) const { 
     return gt(value(), r.value()); 
   }
-  template<TBD_TUPLE_ENUM_PARAMS(class T)> 
-  bool operator<=(const tuple<TBD_TUPLE_ENUM_PARAMS(T)>& r) { 
+  template<class... T> 
+  constexpr bool operator<=(const tuple<T...>& r) const { 
     return lte(value(), r.value()); 
   }
-  template<TBD_TUPLE_ENUM_PARAMS(class T)> 
-  bool operator>=(const tuple<TBD_TUPLE_ENUM_PARAMS(T)>& r) { 
+  template<class... T> 
+  constexpr bool operator>=(const tuple<T...>& r) const { 
     return gte(value(), r.value()); 
   }
   
-  value_type& value() {return *this; }
-  const value_type& value() const {return*this; }
+  TBD_TUPLE_CONSTEXPR14 value_type& value() {return *this; }
+  constexpr const value_type& value() const {return*this; }
 };
 
+//////////////////////// pod
+
+// Tuples of trivially copyable elements (numbers, enums, pointers) are 
+// trivially copyable themselves, arrays of them can be copied as bytes.
+// They are not standard layout: every tuple_item holds its own element.
+
+template<class T> struct is_pod_tuple: std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+template<class T> T* tuple_copy(const T* first, const T* last, T* out, std::true_type) {
+  if (first != last) std::memcpy((void*)out, (const void*)first, (last - first) * sizeof(T));
+  return out + (last - first);
+}
+template<class T> T* tuple_copy(const T* first, const T* last, T* out, std::false_type) {
+  for (; first != last; ++first, ++out) *out = *first;
+  return out;
+}
+
+// assigns [first, last) to the tuples at out, the ranges must not overlap
+template<class T> T* tuple_copy(const T* first, const T* last, T* out) {
+  return tuple_copy(first, last, out, is_pod_tuple<T>());
+}
+
+template<class T> T* tuple_relocate(T* first, T* last, T* out, std::true_type) {
+  if (first != last) std::memmove((void*)out, (const void*)first, (last - first) * sizeof(T));
+  return out + (last - first);
+}
+template<class T> T* tuple_relocate(T* first, T* last, T* out, std::false_type) {
+  std::ptrdiff_t n = last - first;
+  if (out <= first) {
+    for (std::ptrdiff_t i = 0; i < n; ++i) { new (out + i) T(std::move(first[i])); first[i].~T(); }
+  } else {
+    for (std::ptrdiff_t i = n; i-- > 0;) { new (out + i) T(std::move(first[i])); first[i].~T(); }
+  }
+  return out + n;
+}
+
+// moves [first, last) to the raw memory at out and destroys the originals, 
+// the ranges may overlap
+template<class T> T* tuple_relocate(T* first, T* last, T* out) {
+  return tuple_relocate(first, last, out, is_pod_tuple<T>());
+}
+
 } // namespace tuple_details
 
 using tuple_details::tuple; // lifting tuple to tbd namespace
-const tuple_details::Accumulator accu = tuple_details::Accumulator();
-const tuple_details::ignore na = tuple_details::ignore();
+using tuple_details::compare;
+using tuple_details::hash;
+using tuple_details::tuple_hash;
+using tuple_details::is_pod_tuple;
+using tuple_details::tuple_copy;
+using tuple_details::tuple_relocate;
+using tuple_details::field_format;
+using tuple_details::ignore;
+#if TBD_TUPLE_INSTRUMENT
+using tuple_details::tuple_counters;
+using tuple_details::conversion_count;
+using tuple_details::counters_hook;
+using tuple_details::counters;
+using tuple_details::reset_counters;
+using tuple_details::flush_counters;
+using tuple_details::set_counters_hook;
+#endif
+constexpr tuple_details::Accumulator accu = tuple_details::Accumulator();
+constexpr tuple_details::ignore na = tuple_details::ignore();
 
 } // namspace tbd
 
+namespace std {
+template<class... S> struct hash<tbd::tuple<S...> > : tbd::tuple_hash {};
+}
+
 #endif // __tuple_h__
@@ -0,0 +1,347 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+
+#ifndef __tuple_aggregate_h__
+#define __tuple_aggregate_h__
+
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include "tuple.h"
+#include "tuple_table.h"
+
+// AVX2 gathers four rows at a time, TBD_TUPLE_NO_SIMD keeps the scalar loops
+#if defined(__AVX2__) && !defined(TBD_TUPLE_NO_SIMD)
+#  include <immintrin.h>
+#  define TBD_TUPLE_HAS_AVX2 1
+#endif
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// aggregate operations
+
+// Every operation keeps a state per field: init() starts it, add() takes 
+// one element, merge() combines two states and finish() turns the state of
+// n rows into the result. Integers are summed as long long (unsigned long 
+// long), floating point numbers as double.
+
+template<class V> struct sum_type {
+  typedef typename std::conditional<std::is_floating_point<V>::value, double,
+    typename std::conditional<std::is_signed<V>::value, long long, unsigned long long>::type>::type type;
+};
+
+struct aggregate_sum {
+  template<class V> struct state { typedef typename sum_type<V>::type type; };
+  template<class V> struct result { typedef typename sum_type<V>::type type; };
+  template<class V> static typename state<V>::type init() { return 0; }
+  template<class S, class V> static void add(S& s, const V& v) { s += v; }
+  template<class S> static S merge(const S& a, const S& b) { return a + b; }
+  template<class V, class S> static S finish(const S& s, std::size_t) { return s; }
+};
+
+struct aggregate_mean : aggregate_sum {
+  template<class V> struct result { typedef double type; };
+  template<class V, class S> static double finish(const S& s, std::size_t n) { return n ? double(s) / n : 0.0; }
+};
+
+// min and max of no rows are V()
+struct aggregate_min {
+  template<class V> struct state { typedef V type; };
+  template<class V> struct result { typedef V type; };
+  template<class V> static V init() { 
+    return std::numeric_limits<V>::has_infinity ? std::numeric_limits<V>::infinity() : std::numeric_limits<V>::max(); 
+  }
+  template<class S, class V> static void add(S& s, const V& v) { if (v < s) s = v; }
+  template<class S> static S merge(const S& a, const S& b) { return b < a ? b : a; }
+  template<class V, class S> static S finish(const S& s, std::size_t n) { return n ? s : S(); }
+};
+
+struct aggregate_max {
+  template<class V> struct state { typedef V type; };
+  template<class V> struct result { typedef V type; };
+  template<class V> static V init() { 
+    return std::numeric_limits<V>::has_infinity ? -std::numeric_limits<V>::infinity() : std::numeric_limits<V>::lowest(); 
+  }
+  template<class S, class V> static void add(S& s, const V& v) { if (s < v) s = v; }
+  template<class S> static S merge(const S& a, const S& b) { return a < b ? b : a; }
+  template<class V, class S> static S finish(const S& s, std::size_t n) { return n ? s : S(); }
+};
+
+struct aggregate_count {
+  template<class V> struct state { typedef std::size_t type; };
+  template<class V> struct result { typedef std::size_t type; };
+  template<class V> static std::size_t init() { return 0; }
+  template<class S, class V> static void add(S&, const V&) {}
+  template<class S> static S merge(const S& a, const S&) { return a; }
+  template<class V, class S> static std::size_t finish(const S&, std::size_t n) { return n; }
+};
+
+//////////////////////// scalar kernel
+
+// Reduces the element at base, base + stride, ... Four accumulators keep
+// the adds (or compares) of neighbouring rows from waiting on each other.
+template<class V, class Op> struct scalar_kernel {
+  typedef typename Op::template state<V>::type state_type;
+  typedef typename Op::template result<V>::type result_type;
+
+  scalar_kernel(const char* base, std::size_t stride): _base(base), _stride(stride) {
+    for (int k = 0; k < 4; ++k) _state[k] = Op::template init<V>();
+  }
+
+  void add4(std::size_t i) {
+    const char* p = _base + i * _stride;
+    for (int k = 0; k < 4; ++k) Op::add(_state[k], *(const V*)(p + k * _stride));
+  }
+  void add1(std::size_t i) { 
+    Op::add(_state[0], *(const V*)(_base + i * _stride)); 
+  }
+  result_type finish(std::size_t n) const {
+    return Op::template finish<V>(Op::merge(Op::merge(_state[0], _state[1]), Op::merge(_state[2], _state[3])), n);
+  }
+
+protected:
+  const char* _base;
+  std::size_t _stride;
+  state_type _state[4];
+};
+
+//////////////////////// simd kernel
+
+// element types with lanes == 1 are gathered into four lanes of doubles 
+// (double, float) or 64 bit integers (signed 32 and 64 bit integers)
+template<class V, class = void> struct simd_lanes { enum { lanes = 0 }; };
+// operations with lanes == 1 have a vector version
+template<class Op> struct simd_op { enum { lanes = 0 }; };
+
+#if TBD_TUPLE_HAS_AVX2
+
+// the gathers take explicit zero sources and full masks, the plain 
+// intrinsics leave their source undefined (and gcc warns about it)
+
+struct simd_double_lanes {
+  enum { lanes = 1 };
+  typedef __m256d type;
+  typedef double value_type;
+  static type set(double v) { return _mm256_set1_pd(v); }
+  static void store(double* out, type v) { _mm256_storeu_pd(out, v); }
+};
+template<> struct simd_lanes<double> : simd_double_lanes {
+  static type load(const char* p, __m128i offsets) { return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), (const double*)p, offsets, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 1); }
+};
+template<> struct simd_lanes<float> : simd_double_lanes {
+  static type load(const char* p, __m128i offsets) { return _mm256_cvtps_pd(_mm_mask_i32gather_ps(_mm_setzero_ps(), (const float*)p, offsets, _mm_castsi128_ps(_mm_set1_epi32(-1)), 1)); }
+};
+
+struct simd_integer_lanes {
+  enum { lanes = 1 };
+  typedef __m256i type;
+  typedef long long value_type;
+  static type set(long long v) { return _mm256_set1_epi64x(v); }
+  static void store(long long* out, type v) { _mm256_storeu_si256((__m256i*)out, v); }
+};
+template<class V> struct simd_lanes<V, typename std::enable_if<std::is_integral<V>::value && 
+  std::is_signed<V>::value && sizeof(V) == 8>::type> : simd_integer_lanes {
+  static type load(const char* p, __m128i offsets) { return _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), (const long long*)p, offsets, _mm256_set1_epi64x(-1), 1); }
+};
+template<class V> struct simd_lanes<V, typename std::enable_if<std::is_integral<V>::value && 
+  std::is_signed<V>::value && sizeof(V) == 4>::type> : simd_integer_lanes {
+  static type load(const char* p, __m128i offsets) { return _mm256_cvtepi32_epi64(_mm_mask_i32gather_epi32(_mm_setzero_si128(), (const int*)p, offsets, _mm_set1_epi32(-1), 1)); }
+};
+
+template<> struct simd_op<aggregate_sum> {
+  enum { lanes = 1 };
+  static __m256d apply(__m256d s, __m256d v) { return _mm256_add_pd(s, v); }
+  static __m256i apply(__m256i s, __m256i v) { return _mm256_add_epi64(s, v); }
+};
+template<> struct simd_op<aggregate_mean> : simd_op<aggregate_sum> {};
+
+// v first: NaNs are skipped as by the scalar compares
+template<> struct simd_op<aggregate_min> {
+  enum { lanes = 1 };
+  static __m256d apply(__m256d s, __m256d v) { return _mm256_min_pd(v, s); }
+  static __m256i apply(__m256i s, __m256i v) { return _mm256_blendv_epi8(s, v, _mm256_cmpgt_epi64(s, v)); }
+};
+template<> struct simd_op<aggregate_max> {
+  enum { lanes = 1 };
+  static __m256d apply(__m256d s, __m256d v) { return _mm256_max_pd(v, s); }
+  static __m256i apply(__m256i s, __m256i v) { return _mm256_blendv_epi8(s, v, _mm256_cmpgt_epi64(v, s)); }
+};
+
+// Gathers the element of four rows with one instruction, the remaining 
+// rows go through the scalar kernel
+template<class V, class Op> struct simd_kernel : scalar_kernel<V, Op> {
+  typedef scalar_kernel<V, Op> super;
+  typedef simd_lanes<V> lanes;
+
+  simd_kernel(const char* base, std::size_t stride): super(base, stride), 
+    _offsets(_mm_setr_epi32(0, int(stride), int(2 * stride), int(3 * stride))),
+    _lanes(lanes::set(typename lanes::value_type(Op::template init<V>()))) {}
+
+  void add4(std::size_t i) { 
+    _lanes = simd_op<Op>::apply(_lanes, lanes::load(this->_base + i * this->_stride, _offsets)); 
+  }
+  typename super::result_type finish(std::size_t n) const {
+    typename lanes::value_type v[4];
+    lanes::store(v, _lanes);
+    typename super::state_type s = this->_state[0];
+    for (int k = 0; k < 4; ++k) s = Op::merge(s, typename super::state_type(v[k]));
+    return Op::template finish<V>(s, n);
+  }
+
+private:
+  __m128i _offsets;
+  typename lanes::type _lanes;
+};
+
+#endif
+
+template<class V, class Op, bool Simd = simd_lanes<V>::lanes && simd_op<Op>::lanes> struct kernel_for {
+  typedef scalar_kernel<V, Op> type;
+};
+#if TBD_TUPLE_HAS_AVX2
+template<class V, class Op> struct kernel_for<V, Op, true> {
+  typedef simd_kernel<V, Op> type;
+};
+#endif
+
+//////////////////////// aggregate
+
+// element C of the rows starting at first
+template<class T> struct row_source {
+  row_source(const T* first, std::size_t n): _first(first), _n(n) {}
+  template<int C> const char* base() const { return _n ? (const char*)&_first->template get<C>() : 0; }
+  template<int C> std::size_t stride() const { return sizeof(T); }
+  std::size_t size() const { return _n; }
+private:
+  const T* _first;
+  std::size_t _n;
+};
+
+// column C of a tuple_table
+template<class T> struct column_source {
+  column_source(const T& table): _table(table) {}
+  template<int C> const char* base() const { return (const char*)_table.template column<C>().data(); }
+  template<int C> std::size_t stride() const { return sizeof(typename T::template element<C>::type); }
+  std::size_t size() const { return _table.size(); }
+private:
+  const T& _table;
+};
+
+// the operation of field I: the only one or the I-th
+template<std::size_t I, class... Op> struct op_at;
+template<std::size_t I, class Op> struct op_at<I, Op> { typedef Op type; };
+template<class Op, class O2, class... R> struct op_at<0, Op, O2, R...> { typedef Op type; };
+template<std::size_t I, class Op, class O2, class... R> struct op_at<I, Op, O2, R...> : op_at<I - 1, O2, R...> {};
+
+template<class T, int C, class Op> struct aggregate_field {
+  enum { column = C };
+  typedef typename kernel_for<typename T::template element<C>::type, Op>::type kernel;
+  typedef typename kernel::result_type result_type;
+};
+
+// the kernels of all fields, every row is visited once for all of them
+template<class... F> struct field_kernels {
+  template<class S> field_kernels(const S&) {}
+  void add4(std::size_t) {}
+  void add1(std::size_t) {}
+  template<class R> void finish(R&&, std::size_t) const {}
+};
+template<class F, class... R> struct field_kernels<F, R...> : field_kernels<R...> {
+  typedef field_kernels<R...> super;
+  template<class S> field_kernels(const S& source): 
+    super(source), _kernel(source.template base<F::column>(), source.template stride<F::column>()) {}
+
+  void add4(std::size_t i) { _kernel.add4(i); super::add4(i); }
+  void add1(std::size_t i) { _kernel.add1(i); super::add1(i); }
+  template<class C> void finish(C&& collector, std::size_t n) const { 
+    super::finish(collector | _kernel.finish(n), n); 
+  }
+private:
+  typename F::kernel _kernel;
+};
+
+template<int... C> struct column_list {};
+
+template<class T, class Cs, class Is, class... Op> struct aggregator;
+template<class T, int... C, std::size_t... I, class... Op> 
+struct aggregator<T, column_list<C...>, index_sequence<I...>, Op...> {
+  static_assert(sizeof...(Op) == 1 || sizeof...(Op) == sizeof...(C), "one operation or one per field");
+  typedef field_kernels<aggregate_field<T, C, typename op_at<I, Op...>::type>...> kernels;
+  typedef tuple<typename aggregate_field<T, C, typename op_at<I, Op...>::type>::result_type...> result_type;
+
+  template<class S> static result_type run(const S& source) {
+    kernels k(source);
+    const std::size_t n = source.size();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) k.add4(i);
+    for (; i < n; ++i) k.add1(i);
+    result_type result;
+    k.finish(collector<typename result_type::value_type>(result.value()), n);
+    return result;
+  }
+};
+
+template<class T, int... C> struct aggregate_of {
+  template<class... Op> struct with {
+    typedef aggregator<T, column_list<C...>, typename make_indices<sizeof...(C)>::type, Op...> type;
+  };
+};
+
+// Reduces the fields C... of the rows [first, last) in one pass and 
+// returns one result per field as a tuple: aggregate<2>(rows, aggregate_sum())
+// sums element 2, aggregate<0, 2>(rows, aggregate_min(), aggregate_max())
+// gives the minimum of element 0 and the maximum of element 2. 
+template<int... C, class T, class... Op> 
+typename aggregate_of<T, C...>::template with<Op...>::type::result_type 
+aggregate(const T* first, const T* last, const Op&...) {
+  return aggregate_of<T, C...>::template with<Op...>::type::run(row_source<T>(first, last - first));
+}
+
+template<int... C, class T, class... Op> 
+typename aggregate_of<T, C...>::template with<Op...>::type::result_type 
+aggregate(const std::vector<T>& rows, const Op&...) {
+  return aggregate_of<T, C...>::template with<Op...>::type::run(row_source<T>(rows.data(), rows.size()));
+}
+
+template<int... C, class... S, class... Op> 
+typename aggregate_of<tuple_table<S...>, C...>::template with<Op...>::type::result_type 
+aggregate(const tuple_table<S...>& table, const Op&...) {
+  return aggregate_of<tuple_table<S...>, C...>::template with<Op...>::type::run(column_source<tuple_table<S...> >(table));
+}
+
+} // namespace tuple_details
+
+// lifting aggregate to tbd namespace
+using tuple_details::aggregate;
+using tuple_details::aggregate_sum;
+using tuple_details::aggregate_mean;
+using tuple_details::aggregate_min;
+using tuple_details::aggregate_max;
+using tuple_details::aggregate_count;
+
+} // namspace tbd
+
+#endif // __tuple_aggregate_h__
@@ -0,0 +1,96 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "tuple_aggregate.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::aggregate;
+
+typedef tuple<long long, double, float, int, string, short> row;
+
+static_assert(std::is_same<decltype(aggregate<0, 2, 3>(std::vector<row>(), tbd::aggregate_sum())), 
+  tuple<long long, double, long long> >::value, "integers are summed as long long, floating points as double");
+static_assert(std::is_same<decltype(aggregate<2, 5>(std::vector<row>(), tbd::aggregate_min())), tuple<float, short> >::value, "");
+static_assert(std::is_same<decltype(aggregate<1, 3>(std::vector<row>(), tbd::aggregate_mean(), tbd::aggregate_count())), 
+  tuple<double, std::size_t> >::value, "");
+
+
+void check(const std::vector<row>& rows) {
+  long long sum0 = 0, sum3 = 0, sum5 = 0;
+  double sum1 = 0, sum2 = 0;
+  long long min0 = std::numeric_limits<long long>::max(), max0 = std::numeric_limits<long long>::lowest();
+  double min1 = INFINITY, max1 = -INFINITY;
+  float min2 = INFINITY, max2 = -INFINITY;
+  int min3 = std::numeric_limits<int>::max(), max3 = std::numeric_limits<int>::lowest();
+  short min5 = std::numeric_limits<short>::max();
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    const row& r = rows[i];
+    sum0 += r.get<0>(); sum1 += r.get<1>(); sum2 += r.get<2>(); sum3 += r.get<3>(); sum5 += r.get<5>();
+    min0 = std::min(min0, r.get<0>()); max0 = std::max(max0, r.get<0>());
+    min1 = std::min(min1, r.get<1>()); max1 = std::max(max1, r.get<1>());
+    min2 = std::min(min2, r.get<2>()); max2 = std::max(max2, r.get<2>());
+    min3 = std::min(min3, r.get<3>()); max3 = std::max(max3, r.get<3>());
+    min5 = std::min(min5, r.get<5>());
+  }
+  const std::size_t n = rows.size();
+
+  // sums of floating points may add in another order
+  tuple<long long, double, double, long long, long long> sums = aggregate<0, 1, 2, 3, 5>(rows, tbd::aggregate_sum());
+  assert(sums.get<0>() == sum0 && sums.get<3>() == sum3 && sums.get<4>() == sum5);
+  assert(std::fabs(sums.get<1>() - sum1) <= 1e-9 * (1 + std::fabs(sum1)));
+  assert(std::fabs(sums.get<2>() - sum2) <= 1e-9 * (1 + std::fabs(sum2)));
+
+  typedef tuple<long long, double, float, int, short> bounds;
+  bounds mins = aggregate<0, 1, 2, 3, 5>(rows, tbd::aggregate_min());
+  bounds maxs = aggregate<0, 1, 2, 3, 5>(rows, tbd::aggregate_max());
+  if (n) {
+    assert(mins == bounds(accu << min0 | min1 | min2 | min3 | min5));
+    assert(maxs.get<0>() == max0 && maxs.get<1>() == max1 && maxs.get<2>() == max2 && maxs.get<3>() == max3);
+  } else {
+    assert(mins == bounds() && maxs == bounds());
+  }
+
+  // one operation per field, on pointers
+  tuple<double, long long, std::size_t> mixed = aggregate<3, 0, 1>(rows.data(), rows.data() + n, 
+    tbd::aggregate_mean(), tbd::aggregate_max(), tbd::aggregate_count());
+  assert(mixed.get<0>() == (n ? double(sum3) / n : 0.0) && mixed.get<2>() == n);
+  if (n) assert(mixed.get<1>() == max0);
+}
+
+int main() {
+  std::vector<row> rows;
+  check(rows);
+  for (int i = 0; i < 1003; ++i) {
+    rows.push_back(accu << ((long long)(i * 7919 % 1000 - 500) * 1000000007LL) | ((i % 13) * 0.25 - 1.0) | 
+      (float(i % 17) - 8.5f) | (i * 31 % 997 - 400) | "x" | short(i % 7 - 3));
+    if (i < 9 || i % 100 == 0) check(rows);
+  }
+  check(rows);
+
+  // NaNs are skipped by min and max
+  tuple<double, double> nan(accu << std::nan("") | 1.0);
+  std::vector<tuple<double, double> > with_nan(9, tuple<double, double>(accu << 2.0 | 1.0));
+  with_nan[5] = nan;
+  assert(aggregate<0>(with_nan, tbd::aggregate_min()).get<0>() == 2.0);
+  assert(aggregate<0>(with_nan, tbd::aggregate_max()).get<0>() == 2.0);
+
+  // tables aggregate their columns
+  tbd::tuple_table<int, double, string> table;
+  for (int i = 0; i < 10; ++i) table << i | i * 0.5 | "t";
+  tuple<long long, double> t = aggregate<0, 1>(table, tbd::aggregate_sum());
+  assert(t.get<0>() == 45 && t.get<1>() == 22.5);
+  assert(aggregate<1>(table, tbd::aggregate_max()).get<0>() == 4.5);
+
+  cout << "aggregate<0, 1, 2>: " << aggregate<0, 1, 2>(rows, tbd::aggregate_mean()).join(", ") << endl;
+  return 0;
+}
@@ -0,0 +1,392 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+
+#ifndef __tuple_arena_h__
+#define __tuple_arena_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if __cplusplus >= 201703L
+#  include <string_view>
+#endif
+#include "tuple.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// tuple_arena
+
+// A bump allocator for request scoped rows: allocations move a pointer 
+// forward in large blocks and are never freed one by one, release() drops 
+// all of them at once. Allocations larger than a quarter block get a block
+// of their own. The arena also interns strings: intern() returns the same 
+// pointer for equal text until the next release().
+struct tuple_arena {
+  explicit tuple_arena(std::size_t block_size = 64 * 1024): 
+    _blocks(0), _large(0), _pos(0), _end(0), _block_size(block_size), _allocated(0), _interned(0) {}
+  ~tuple_arena() { 
+    free_blocks(_blocks, 0); 
+    free_blocks(_large, 0); 
+  }
+
+  tuple_arena(const tuple_arena&) = delete;
+  tuple_arena& operator= (const tuple_arena&) = delete;
+
+  void* allocate(std::size_t n, std::size_t align = alignof(std::max_align_t)) {
+    _allocated += n;
+    if (n + align > _block_size / 4) return align_up(add_block(_large, n + align)->data(), align);
+    char* p = align_up(_pos, align);
+    if (!_pos || n > std::size_t(_end - p)) {
+      block* b = add_block(_blocks, _block_size);
+      _pos = b->data();
+      _end = _pos + _block_size;
+      p = align_up(_pos, align);
+    }
+    _pos = p + n;
+    return p;
+  }
+
+  // copies n chars (and a terminating 0) into the arena
+  const char* copy(const char* s, std::size_t n) {
+    char* p = (char*)allocate(n + 1, 1);
+    std::memcpy(p, s, n);
+    p[n] = 0;
+    return p;
+  }
+
+  // the copy of equal text made by the first intern() since release()
+  const char* intern(const char* s, std::size_t n) {
+    if (!n) return empty_text();
+    if (2 * (_interned + 1) > _table.size()) grow_table();
+    std::uint64_t h = hash_text(s, n);
+    for (std::size_t i = h & (_table.size() - 1);; i = (i + 1) & (_table.size() - 1)) {
+      interned_entry& e = _table[i];
+      if (!e.text) {
+        e.text = copy(s, n);
+        e.size = n;
+        e.hash = h;
+        ++_interned;
+        return e.text;
+      }
+      if (e.hash == h && e.size == n && !std::memcmp(e.text, s, n)) return e.text;
+    }
+  }
+
+  // frees everything but the first block, which is reused
+  void release() {
+    block* keep = _blocks;
+    while (keep && keep->next) keep = keep->next;
+    free_blocks(_blocks, keep);
+    free_blocks(_large, 0);
+    _blocks = keep;
+    _large = 0;
+    _pos = keep ? keep->data() : 0;
+    _end = keep ? keep->data() + _block_size : 0;
+    _allocated = 0;
+    if (_interned) {
+      for (std::size_t i = 0; i < _table.size(); ++i) _table[i] = interned_entry();
+      _interned = 0;
+    }
+  }
+
+  // bytes handed out since the last release()
+  std::size_t allocated() const { return _allocated; }
+
+  // the arena of arena_scope on this thread (or a per thread fallback)
+  static tuple_arena& current() { 
+    tuple_arena* a = current_ref();
+    return a ? *a : thread_arena(); 
+  }
+  static tuple_arena*& current_ref() { static thread_local tuple_arena* a = 0; return a; }
+  static tuple_arena& thread_arena() { static thread_local tuple_arena a; return a; }
+
+  // shared by all empty strings, so interned empty strings are equal as well
+  static const char* empty_text() { static const char e = 0; return &e; }
+
+private:
+  struct block {
+    block* next;
+    std::max_align_t padding; // data() is aligned for any type
+    char* data() { return (char*)(this + 1); }
+  };
+  struct interned_entry {
+    interned_entry(): text(0), size(0), hash(0) {}
+    const char* text;
+    std::size_t size;
+    std::uint64_t hash;
+  };
+
+  static char* align_up(char* p, std::size_t align) {
+    return (char*)(((std::uintptr_t)p + align - 1) & ~(std::uintptr_t)(align - 1));
+  }
+  static std::uint64_t hash_text(const char* s, std::size_t n) {
+    std::uint64_t h = n;
+    for (; n >= 8; s += 8, n -= 8) {
+      std::uint64_t w;
+      std::memcpy(&w, s, 8);
+      h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+    }
+    std::uint64_t w = 0;
+    std::memcpy(&w, s, n);
+    return mix_hash(h ^ w);
+  }
+
+  static block* add_block(block*& list, std::size_t size) {
+    block* b = (block*)::operator new(sizeof(block) + size);
+    b->next = list;
+    list = b;
+    return b;
+  }
+  static void free_blocks(block* b, block* keep) {
+    while (b) {
+      block* next = b->next;
+      if (b != keep) ::operator delete(b);
+      b = next;
+    }
+    if (keep) keep->next = 0;
+  }
+  void grow_table() {
+    std::vector<interned_entry> table(_table.empty() ? 64 : 2 * _table.size());
+    for (std::size_t i = 0; i < _table.size(); ++i) {
+      if (!_table[i].text) continue;
+      std::size_t j = _table[i].hash & (table.size() - 1);
+      while (table[j].text) j = (j + 1) & (table.size() - 1);
+      table[j] = _table[i];
+    }
+    _table.swap(table);
+  }
+
+  block* _blocks;
+  block* _large;
+  char* _pos;
+  char* _end;
+  std::size_t _block_size;
+  std::size_t _allocated;
+  std::size_t _interned;
+  std::vector<interned_entry> _table;
+};
+
+// makes an arena the current one of this thread until the end of the scope,
+// strings and containers of arena tuples created meanwhile draw from it
+struct arena_scope {
+  explicit arena_scope(tuple_arena& arena): _previous(tuple_arena::current_ref()) { 
+    tuple_arena::current_ref() = &arena; 
+  }
+  ~arena_scope() { tuple_arena::current_ref() = _previous; }
+
+  arena_scope(const arena_scope&) = delete;
+  arena_scope& operator= (const arena_scope&) = delete;
+private:
+  tuple_arena* _previous;
+};
+
+//////////////////////// arena_allocator
+
+// allocator for container elements of arena tuples, deallocate does nothing
+template<class T> struct arena_allocator {
+  typedef T value_type;
+
+  arena_allocator(): _arena(&tuple_arena::current()) {}
+  arena_allocator(tuple_arena& arena): _arena(&arena) {}
+  template<class U> arena_allocator(const arena_allocator<U>& other): _arena(&other.arena()) {}
+
+  T* allocate(std::size_t n) { return (T*)_arena->allocate(n * sizeof(T), alignof(T)); }
+  void deallocate(T*, std::size_t) {}
+
+  tuple_arena& arena() const { return *_arena; }
+private:
+  tuple_arena* _arena;
+};
+
+template<class T, class U> bool operator== (const arena_allocator<T>& l, const arena_allocator<U>& r) { 
+  return &l.arena() == &r.arena(); 
+}
+template<class T, class U> bool operator!= (const arena_allocator<T>& l, const arena_allocator<U>& r) { 
+  return &l.arena() != &r.arena(); 
+}
+
+template<class T> using arena_vector = std::vector<T, arena_allocator<T> >;
+
+//////////////////////// arena_string
+
+// An immutable string in an arena: a pointer and a size, copying it copies
+// neither the text nor allocates. Created from text it copies the text into
+// the current arena (interned_string interns it), so the arena must outlive
+// the string. Two interned strings of the same arena are equal when their 
+// pointers are, strings of different arenas compare their text.
+template<bool Interned> struct basic_arena_string {
+  typedef basic_arena_string<Interned> self;
+  enum { interned = Interned };
+
+  basic_arena_string(): _data(tuple_arena::empty_text()), _size(0) {}
+  basic_arena_string(const char* s): _data(store(tuple_arena::current(), s, std::strlen(s))), _size(std::strlen(s)) {}
+  basic_arena_string(const std::string& s): _data(store(tuple_arena::current(), s.data(), s.size())), _size(s.size()) {}
+  basic_arena_string(const char* s, std::size_t n): _data(store(tuple_arena::current(), s, n)), _size(n) {}
+  basic_arena_string(tuple_arena& arena, const char* s, std::size_t n): _data(store(arena, s, n)), _size(n) {}
+
+  // an interned string is also an arena string, the other way it is interned
+  template<bool I> basic_arena_string(const basic_arena_string<I>& s): 
+    _data(I && !Interned ? s.data() : store(tuple_arena::current(), s.data(), s.size())), _size(s.size()) {}
+
+  const char* data() const { return _data; }
+  const char* c_str() const { return _data; }
+  std::size_t size() const { return _size; }
+  bool empty() const { return !_size; }
+  const char* begin() const { return _data; }
+  const char* end() const { return _data + _size; }
+
+  std::string str() const { return std::string(_data, _size); }
+  operator std::string() const { return str(); }
+
+  int compare(const char* s, std::size_t n) const {
+    int c = std::memcmp(_data, s, _size < n ? _size : n);
+    return c ? c : _size < n ? -1 : _size > n ? 1 : 0;
+  }
+private:
+  static const char* store(tuple_arena& arena, const char* s, std::size_t n) { 
+    return Interned ? arena.intern(s, n) : n ? arena.copy(s, n) : tuple_arena::empty_text(); 
+  }
+
+  const char* _data;
+  std::size_t _size;
+};
+
+typedef basic_arena_string<false> arena_string;
+typedef basic_arena_string<true> interned_string;
+
+template<bool I1, bool I2> inline bool same_text(const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) {
+  if (I1 && I2 && l.data() == r.data()) return true;
+  return l.size() == r.size() && !std::memcmp(l.data(), r.data(), l.size());
+}
+template<bool I> inline bool same_text(const basic_arena_string<I>& l, const std::string& r) {
+  return l.size() == r.size() && !std::memcmp(l.data(), r.data(), l.size());
+}
+template<bool I> inline bool same_text(const basic_arena_string<I>& l, const char* r) {
+  return !l.compare(r, std::strlen(r));
+}
+
+template<bool I1, bool I2> inline bool operator== (const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { return same_text(l, r); }
+template<bool I1, bool I2> inline bool operator!= (const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { return !same_text(l, r); }
+template<bool I> inline bool operator== (const basic_arena_string<I>& l, const std::string& r) { return same_text(l, r); }
+template<bool I> inline bool operator!= (const basic_arena_string<I>& l, const std::string& r) { return !same_text(l, r); }
+template<bool I> inline bool operator== (const std::string& l, const basic_arena_string<I>& r) { return same_text(r, l); }
+template<bool I> inline bool operator!= (const std::string& l, const basic_arena_string<I>& r) { return !same_text(r, l); }
+template<bool I> inline bool operator== (const basic_arena_string<I>& l, const char* r) { return same_text(l, r); }
+template<bool I> inline bool operator!= (const basic_arena_string<I>& l, const char* r) { return !same_text(l, r); }
+template<bool I> inline bool operator== (const char* l, const basic_arena_string<I>& r) { return same_text(r, l); }
+template<bool I> inline bool operator!= (const char* l, const basic_arena_string<I>& r) { return !same_text(r, l); }
+
+// compare_values is found by the comparisons of tuple.h, one memcmp per element
+template<bool I1, bool I2> inline int compare_values(const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { 
+  return I1 && I2 && l.data() == r.data() ? 0 : l.compare(r.data(), r.size()); 
+}
+template<bool I> inline int compare_values(const basic_arena_string<I>& l, const std::string& r) { 
+  return l.compare(r.data(), r.size()); 
+}
+template<bool I> inline int compare_values(const std::string& l, const basic_arena_string<I>& r) { 
+  return -r.compare(l.data(), l.size()); 
+}
+
+template<bool I1, bool I2> inline bool operator< (const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { return compare_values(l, r) < 0; }
+template<bool I1, bool I2> inline bool operator> (const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { return compare_values(l, r) > 0; }
+template<bool I1, bool I2> inline bool operator<= (const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { return compare_values(l, r) <= 0; }
+template<bool I1, bool I2> inline bool operator>= (const basic_arena_string<I1>& l, const basic_arena_string<I2>& r) { return compare_values(l, r) >= 0; }
+template<bool I> inline bool operator< (const basic_arena_string<I>& l, const std::string& r) { return compare_values(l, r) < 0; }
+template<bool I> inline bool operator< (const std::string& l, const basic_arena_string<I>& r) { return compare_values(l, r) < 0; }
+
+template<bool I> inline std::ostream& operator<< (std::ostream& out, const basic_arena_string<I>& s) {
+  return out.write(s.data(), s.size());
+}
+
+// hashes like std::string, so arena tuples and tuples hash the same
+template<bool I> inline std::size_t hash_value(const basic_arena_string<I>& s) {
+#if __cplusplus >= 201703L
+  return std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+#else
+  return std::hash<std::string>()(s.str());
+#endif
+}
+
+// join writes the text as it is
+template<class Sink, bool I> inline void write_text(Sink& out, const basic_arena_string<I>& s, const field_format&) {
+  out.append(s.data(), s.size());
+}
+
+// get<std::string>(i) copies the text, numbers are parsed without a stream
+template<bool I> struct value_converter<std::string, basic_arena_string<I> > {
+  static std::string do_it(const basic_arena_string<I>& v) { return v.str(); }
+};
+
+#if TBD_TUPLE_HAS_CHARCONV
+
+template<class To, bool I> struct value_converter<To, basic_arena_string<I>, 
+  typename std::enable_if<is_number<To>::value>::type> {
+  static To do_it(const basic_arena_string<I>& v) {
+    To value = To();
+    parse_number(v.data(), v.data() + v.size(), value);
+    return value;
+  }
+};
+
+#endif
+
+//////////////////////// arena_tuple
+
+// arena_tuple<int, std::string, std::vector<int> > is a tuple<int, 
+// arena_string, arena_vector<int> >, other element types are kept
+template<class T> struct arena_element { typedef T type; };
+template<> struct arena_element<std::string> { typedef arena_string type; };
+template<class T> struct arena_element<std::vector<T> > { typedef arena_vector<T> type; };
+
+template<class... S> using arena_tuple = tuple<typename arena_element<S>::type...>;
+
+} // namespace tuple_details
+
+// lifting the arena types to tbd namespace
+using tuple_details::tuple_arena;
+using tuple_details::arena_scope;
+using tuple_details::arena_allocator;
+using tuple_details::arena_vector;
+using tuple_details::arena_string;
+using tuple_details::interned_string;
+using tuple_details::arena_tuple;
+
+} // namspace tbd
+
+namespace std {
+template<bool I> struct hash<tbd::tuple_details::basic_arena_string<I> > {
+  std::size_t operator()(const tbd::tuple_details::basic_arena_string<I>& s) const { 
+    return tbd::tuple_details::hash_value(s); 
+  }
+};
+}
+
+#endif // __tuple_arena_h__
@@ -0,0 +1,109 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "tuple_arena.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::arena_tuple;
+using tbd::arena_string;
+using tbd::interned_string;
+
+static_assert(std::is_same<arena_tuple<int, string, double>, tuple<int, arena_string, double> >::value, "");
+static_assert(std::is_same<arena_tuple<int, interned_string>, tuple<int, interned_string> >::value, "");
+static_assert(std::is_same<arena_tuple<std::vector<int> >::element<0>::type, tbd::arena_vector<int> >::value, "");
+static_assert(std::is_trivially_copyable<arena_tuple<int, string, double> >::value, "");
+
+int main() {
+  tbd::tuple_arena arena(1024);
+  typedef arena_tuple<int, string, double> row;
+  typedef tuple<int, string, double> plain;
+  {
+    tbd::arena_scope scope(arena);
+
+    // strings are copied into the arena, copying rows copies pointers
+    string name("a name longer than the small string buffer");
+    row r(accu << 7 | name | 0.5);
+    assert(r.get<1>() == name && r.get<1>().data() != name.data());
+    assert(r.get<1>().c_str()[name.size()] == 0);
+    assert(arena.allocated() == name.size() + 1);
+    row copy(r);
+    assert(copy.get<1>().data() == r.get<1>().data() && arena.allocated() == name.size() + 1);
+
+    // <<, >> and join as for tuples
+    r << 8 | "eight" | 1.5;
+    int i = 0;
+    string s;
+    double d = 0;
+    r >> i | s | d;
+    assert(i == 8 && s == "eight" && d == 1.5);
+    assert(r.join(",") == "8,eight,1.5");
+    assert(r.get<string>(1) == "eight" && r.get<string>(0) == "8");
+    row number(accu << 1 | "42" | 0.0);
+    assert(number.get<int>(1) == 42);
+
+    // comparisons against ordinary tuples, both ways, and hashing
+    plain p(accu << 8 | "eight" | 1.5);
+    assert(r == p && p == r && !(r != p));
+    assert(r < plain(accu << 8 | "nine" | 0.0) && plain(accu << 8 | "eat" | 9.0) < r);
+    assert(tbd::compare(r, p) == 0 && tbd::hash(r) == tbd::hash(p));
+    assert(r.get<1>() < string("f") && string("a") < r.get<1>());
+
+    // interned strings share their text, equal means equal pointers
+    typedef arena_tuple<interned_string, int> key;
+    key a(accu << string("symbol") | 1), b(accu << "symbol" | 2);
+    assert(a.get<0>().data() == b.get<0>().data());
+    assert(a.get<0>() == b.get<0>() && a.get<0>() == "symbol" && a.get<0>() != "other");
+    std::size_t used = arena.allocated();
+    for (int n = 0; n < 1000; ++n) a.set<0>(interned_string("symbol"));
+    assert(arena.allocated() == used);
+    assert(interned_string(arena_string("symbol")).data() == a.get<0>().data());
+    assert(interned_string() == interned_string(""));
+    std::unordered_set<interned_string> symbols;
+    symbols.insert(a.get<0>());
+    assert(symbols.count(interned_string("symbol")) == 1);
+
+    // large strings and containers
+    string large(2000, 'x');
+    row big(accu << 1 | large | 0.0);
+    assert(big.get<1>() == large);
+    arena_tuple<int, std::vector<int> > v;
+    for (int n = 0; n < 100; ++n) v.get<1>().push_back(n);
+    assert(v.get<1>().size() == 100 && v.get<1>()[99] == 99);
+    assert(&v.get<1>().get_allocator().arena() == &arena);
+  }
+
+  // everything goes at once, the first block is reused
+  arena.release();
+  assert(arena.allocated() == 0);
+  {
+    tbd::arena_scope scope(arena);
+    interned_string s("symbol");
+    assert(s == "symbol" && arena.allocated() == 7);
+
+    // the same text interned in another arena is still equal
+    tbd::tuple_arena other(1024);
+    interned_string t(other, "symbol", 6);
+    assert(t.data() != s.data() && t == s && !(t != s));
+    assert(compare_values(t, s) == 0 && hash_value(t) == hash_value(s)); // found by ADL
+    typedef tuple<interned_string, int> key;
+    key a(accu << s | 1), b(accu << t | 1);
+    assert(a == b && !(a < b) && !(b < a) && tbd::hash(a) == tbd::hash(b));
+  }
+
+  // without a scope strings go to the arena of the thread
+  arena_string loose("loose");
+  assert(&tbd::tuple_arena::current() == &tbd::tuple_arena::thread_arena());
+  assert(loose == "loose");
+
+  cout << "arena row: " << row(accu << 1 | "one" | 1.0).join(", ") << endl;
+  return 0;
+}
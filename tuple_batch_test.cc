@@ -0,0 +1,96 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <cassert>
+#include <type_traits>
+
+#include "tuple_batch.h"
+#include "tuple_packed.h"
+using tbd::accu;
+using tbd::tuple;
+
+typedef tuple<int, long long, short, double> row;
+
+// sums every element, the index picks the sum at compile time
+struct summer {
+  long long sums[4];
+  double fraction;
+
+  summer(): fraction(0) { for (int i = 0; i < 4; ++i) sums[i] = 0; }
+  template<class V, std::size_t I> void operator() (const V& v, std::integral_constant<std::size_t, I>) { sums[I] += (long long)v; }
+  void operator() (const double& v, std::integral_constant<std::size_t, 3>) { fraction += v - (long long)v; sums[3] += (long long)v; }
+  void merge(const summer& other) { 
+    for (int i = 0; i < 4; ++i) sums[i] += other.sums[i]; 
+    fraction += other.fraction;
+  }
+};
+
+// records the static type of the index
+struct indices {
+  string seen;
+  template<class V, std::size_t I> void operator() (const V&, std::integral_constant<std::size_t, I>) { 
+    seen += char('0' + I); 
+  }
+};
+
+struct doubler {
+  long long sum;
+  template<class V, std::size_t I> void operator() (const V& v, std::integral_constant<std::size_t, I>) { sum += (long long)(v * 2); }
+};
+
+int main() {
+  row r(accu << 1 | 2LL | short(3) | 4.5);
+  indices seen;
+  r.visit(seen);
+  assert(seen.seen == "0123");
+  assert(r.join(",") == "1,2,3,4.5");
+
+  vector<row> rows;
+  // enough rows for 4 threads of batch_thread_rows
+  for (int i = 0; i < 300000; ++i) rows.push_back(accu << i | i * 3LL | short(i % 7) | i + 0.5);
+
+  summer by_row;
+  for (std::size_t i = 0; i < rows.size(); ++i) rows[i].visit(by_row);
+
+  summer batch;
+  tbd::accept_batch(rows.begin(), rows.end(), batch);
+  for (int i = 0; i < 4; ++i) assert(batch.sums[i] == by_row.sums[i]);
+  assert(batch.fraction == by_row.fraction);
+
+  unsigned threads[] = { 0, 1, 3, 8 };
+  for (int t = 0; t < 4; ++t) {
+    summer parallel;
+    tbd::parallel_accept(rows.begin(), rows.end(), parallel, threads[t]);
+    for (int i = 0; i < 4; ++i) assert(parallel.sums[i] == by_row.sums[i]);
+  }
+
+  // a table is visited column by column
+  tbd::tuple_table<int, long long, short, double> table;
+  for (std::size_t i = 0; i < rows.size(); ++i) table.push_back(rows[i]);
+  summer columns;
+  tbd::accept_batch(table, columns);
+  for (int i = 0; i < 4; ++i) assert(columns.sums[i] == by_row.sums[i]);
+  summer parallel_columns;
+  tbd::parallel_accept(table, parallel_columns, 3);
+  for (int i = 0; i < 4; ++i) assert(parallel_columns.sums[i] == by_row.sums[i]);
+
+  summer few;
+  tbd::parallel_accept(rows.begin(), rows.begin() + 10, few, 4);
+  assert(few.sums[0] == 45);
+
+  // works on everything with get<I>()
+  vector<tbd::packed_tuple<short, double> > packed(100, accu << short(2) | 0.5);
+  doubler twice = { 0 };
+  tbd::accept_batch(packed.begin(), packed.end(), twice);
+  assert(twice.sum == 500);
+
+  cout << "visited " << rows.size() << " rows" << endl;
+  return 0;
+}
@@ -0,0 +1,1038 @@
+// Micro benchmarks, build with optimizations: g++ -O2 -std=c++17 tuple_bench.cc
+// The optional argument sets the number of rows (default 2000000).
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include "tuple.h"
+#include "tuple_table.h"
+#include "tuple_writer.h"
+#include "tuple_reader.h"
+#include "tuple_record.h"
+#include "tuple_sort.h"
+#include "tuple_map.h"
+#include "tuple_packed.h"
+#include "tuple_batch.h"
+#include "tuple_select.h"
+#include "tuple_index.h"
+#include "tuple_queue.h"
+#include "tuple_arena.h"
+#include "tuple_aggregate.h"
+#include "tuple_merge.h"
+#include <fcntl.h>
+#include <unistd.h>
+using tbd::accu;
+using tbd::tuple;
+using tbd::tuple_table;
+using tbd::text_writer;
+using tbd::text_parser;
+using tbd::text_reader;
+using tbd::mapped_file;
+using tbd::record_file;
+using tbd::record_writer;
+using tbd::flat_map;
+using tbd::packed_tuple;
+using tbd::selection;
+using tbd::tuple_index;
+using tbd::spsc_queue;
+using tbd::mpmc_queue;
+using tbd::aggregate;
+using tbd::external_sort_config;
+using tbd::external_sorter;
+
+// keeps the optimizer from dropping unused (arithmetic) results
+template<class T> void keep(T value) {
+  static volatile T sink;
+  sink = value;
+  (void)sink;
+}
+
+// counts heap allocations
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+std::atomic<std::size_t> allocations(0);
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// allocations done during the last measure
+std::size_t measured_allocations = 0;
+
+// runs f and returns the elapsed milliseconds
+template<class F> double measure(F f) {
+  std::size_t before = allocations;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  f();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  measured_allocations = allocations - before;
+  return ms;
+}
+
+void report(const char* name, double ms, std::size_t n) {
+  cout << name << ": " << ms << " ms (" << ms * 1e6 / n << " ns/op, " 
+       << double(measured_allocations) / n << " allocs/op)" << endl;
+}
+
+//////////////////////// tuple_table vs. vector<tuple>
+
+void bench_table(std::size_t n) {
+  typedef tuple<int, string, double> row;
+  vector<row> rows;
+  tuple_table<int, string, double> table;
+  rows.reserve(n);
+  table.reserve(n);
+
+  for (std::size_t i = 0; i < n; ++i) {
+    string name = "a string that does not fit into SSO #" + std::to_string(i);
+    rows.push_back(accu << int(i) | name | i * 0.5);
+    table << int(i) | name | i * 0.5;
+  }
+
+  double sum = 0;
+  report("vector<tuple> sum get<2>", measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) sum += rows[i].get<2>();
+  }), n);
+  keep(sum);
+
+  sum = 0;
+  report("tuple_table sum column<2>", measure([&] {
+    for (double d : table.column<2>()) sum += d;
+  }), n);
+  keep(sum);
+
+  long long ids = 0;
+  report("vector<tuple> sum get<0>", measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) ids += rows[i].get<0>();
+  }), n);
+  keep(ids);
+
+  ids = 0;
+  report("tuple_table sum column<0>", measure([&] {
+    for (int id : table.column<0>()) ids += id;
+  }), n);
+  keep(ids);
+}
+
+//////////////////////// sort
+
+// the comparison tuple.h used before compare(): two operator< per element
+template<class T1> bool legacy_lt(const T1&, const tbd::tuple_details::tuple_end&) { return false; }
+template<class T2> bool legacy_lt(const tbd::tuple_details::tuple_end&, const T2&) { return true; }
+inline bool legacy_lt(const tbd::tuple_details::tuple_end&, const tbd::tuple_details::tuple_end&) { return false; }
+template<class T1, class T2> bool legacy_lt(const T1& lhs, const T2& rhs) {
+  return lhs.head() < rhs.head() || (!(rhs.head() < lhs.head()) && legacy_lt(lhs.tail(), rhs.tail()));
+}
+
+void bench_sort(std::size_t n) {
+  typedef tuple<string, int, double> row;
+  std::mt19937 random(42);
+  vector<row> rows;
+  rows.reserve(n);
+  // few distinct strings with a long common prefix so ties are common
+  for (std::size_t i = 0; i < n; ++i) {
+    rows.push_back(accu << "customer/region/" + std::to_string(random() % 1000) | int(random() % 100) | double(random()));
+  }
+
+  vector<row> sorted = rows;
+  report("sort legacy two-pass lt", measure([&] {
+    std::sort(sorted.begin(), sorted.end(), [](const row& l, const row& r) { 
+      return legacy_lt(l.value(), r.value()); 
+    });
+  }), n);
+
+  sorted = rows;
+  report("sort operator< (compare)", measure([&] {
+    std::sort(sorted.begin(), sorted.end(), [](const row& l, const row& r) { return l < r; });
+  }), n);
+  keep(sorted.front().get<1>());
+
+  sorted = rows;
+  report("radix_sort", measure([&] { tbd::radix_sort(sorted.begin(), sorted.end()); }), n);
+  keep(sorted.front().get<1>());
+
+  sorted = rows;
+  report("parallel_sort", measure([&] { tbd::parallel_sort(sorted.begin(), sorted.end()); }), n);
+  keep(sorted.front().get<1>());
+
+  typedef tuple<int, double> number_row;
+  vector<number_row> numbers, sorted_numbers;
+  numbers.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) numbers.push_back(accu << int(random()) | double(random()) / 7);
+
+  sorted_numbers = numbers;
+  report("sort tuple<int, double> operator<", measure([&] { std::sort(sorted_numbers.begin(), sorted_numbers.end()); }), n);
+  sorted_numbers = numbers;
+  report("radix_sort tuple<int, double>", measure([&] { tbd::radix_sort(sorted_numbers.begin(), sorted_numbers.end()); }), n);
+  sorted_numbers = numbers;
+  report("parallel_sort tuple<int, double>", measure([&] { tbd::parallel_sort(sorted_numbers.begin(), sorted_numbers.end()); }), n);
+  keep(sorted_numbers.front().get<0>());
+}
+
+//////////////////////// runtime indexed access
+
+// the stringstream conversion used before value_converter
+template<class Tuple, class To, class Sub> struct legacy_convert {
+  static To do_it(const Tuple& t) {
+    To value;
+    std::stringstream _sstr;
+    _sstr.precision(15);
+    _sstr << ((Sub&)t).head();
+    _sstr >> value;
+    return value;
+  }
+};
+template<class Tuple, class Sub> struct legacy_convert<Tuple, typename Sub::head_type, Sub> {
+  static typename Sub::head_type do_it(const Tuple& t) { return ((Sub&)t).head(); }
+};
+
+// the lazily filled function table converter used before convert_at
+template<class TT, class VT> struct legacy_converter {
+  typedef VT(*pt_convert)(const TT&);
+
+  template<class T> static void create(pt_convert* ft, T*) {
+    *ft = legacy_convert<TT, VT, T>::do_it;
+    create(++ft, (typename T::tail_type*)0);
+  }
+  static void create(pt_convert*, tbd::tuple_details::tuple_end*) {}
+
+  static VT get(const TT& tuple, int i) {
+    static pt_convert ft[TT::size] = {0};
+    if (!ft[0]) create(ft, (TT*)0);
+    if (i >= TT::size) return VT();
+    return ft[i](tuple);
+  }
+};
+
+void bench_get_runtime(std::size_t n) {
+  typedef tuple<double, double, double, double, double> row;
+  typedef row::value_type value_type;
+  row r(accu << 1.0 | 2.0 | 3.0 | 4.0 | 5.0);
+  const int size = value_type::size;
+
+  double sum = 0;
+  report("get<double>(i) legacy function table", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += legacy_converter<value_type, double>::get(r.value(), int(i % size));
+  }), n);
+  keep(sum);
+
+  sum = 0;
+  report("get<double>(i)", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += r.get<double>(int(i % size));
+  }), n);
+  keep(sum);
+}
+
+//////////////////////// conversion
+
+void bench_convert(std::size_t n) {
+  typedef tuple<int, string, double, float> row;
+  typedef row::value_type value_type;
+  row r(accu << 12 | "34.56" | 78.9 | 0.5f);
+  const int size = value_type::size;
+
+  double sum = 0;
+  report("get<double>(i) stringstream", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) {
+      sum += legacy_converter<value_type, double>::get(r.value(), int(i % size));
+    }
+  }), n);
+  keep(sum);
+
+  sum = 0;
+  report("get<double>(i)", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += r.get<double>(int(i % size));
+  }), n);
+  keep(sum);
+
+  std::size_t length = 0;
+  report("get<string>(i) stringstream", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) {
+      length += legacy_converter<value_type, string>::get(r.value(), int(i % size)).size();
+    }
+  }), n);
+  keep(length);
+
+  length = 0;
+  report("get<string>(i)", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) length += r.get<string>(int(i % size)).size();
+  }), n);
+  keep(length);
+}
+
+//////////////////////// join
+
+void report_rows(const char* name, double ms, std::size_t n) {
+  cout << name << ": " << ms << " ms (" << n / ms * 1e3 << " rows/s, " 
+       << double(measured_allocations) / n << " allocs/row)" << endl;
+}
+
+// the stringstream joiner join used before join_to
+struct legacy_joiner {
+  legacy_joiner(std::string separator): _sep(separator) {}
+  template<class T> void operator() (const T& value, int i) {
+    if (i) _sstr << _sep;
+    _sstr << value;
+  }
+  std::string str() { return _sstr.str(); }
+private:
+  std::stringstream _sstr;
+  std::string _sep;
+};
+
+void bench_join(std::size_t n) {
+  typedef tuple<int, string, double, long long> row;
+  row r(accu << 42 | "sally" | 47.11 | 1234567890123LL);
+
+  std::size_t length = 0;
+  report_rows("join(\", \") stringstream", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) {
+      legacy_joiner visitor(", ");
+      length += r.accept(visitor).str().size();
+    }
+  }), n);
+  keep(length);
+
+  report_rows("join(\", \")", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) length += r.join(", ").size();
+  }), n);
+  keep(length);
+
+  string line;
+  report_rows("join_to(string&, \", \")", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) {
+      line.clear();
+      length += r.join_to(line, ", ").size();
+    }
+  }), n);
+  keep(length);
+
+  char buffer[256];
+  report_rows("join_to(char*, capacity, \", \")", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) length += r.join_to(buffer, sizeof(buffer), ", ") - buffer;
+  }), n);
+  keep(length);
+
+  int fd = open("/dev/null", O_WRONLY);
+  text_writer out(fd);
+  report_rows("text_writer /dev/null", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) out.write(r, ", ");
+    out.flush();
+  }), n);
+  close(fd);
+}
+
+//////////////////////// parse
+
+void report_bytes(const char* name, double ms, std::size_t n, std::size_t bytes) {
+  cout << name << ": " << ms << " ms (" << n / ms * 1e3 << " rows/s, " << bytes / ms / 1e3 << " MB/s, " 
+       << double(measured_allocations) / n << " allocs/row)" << endl;
+}
+
+void bench_parse(std::size_t n) {
+  typedef tuple<int, string, double> row;
+  string text;
+  for (std::size_t i = 0; i < n; ++i) {
+    row(accu << int(i) | "name " + std::to_string(i % 1000) | i * 0.25).join_to(text, ",");
+    text += '\n';
+  }
+
+  std::size_t count = 0;
+  report_bytes("getline + stringstream", measure([&] {
+    std::istringstream in(text);
+    string line, field;
+    row r;
+    while (std::getline(in, line)) {
+      std::istringstream fields(line);
+      std::getline(fields, field, ',');
+      r.get<0>() = std::atoi(field.c_str());
+      std::getline(fields, r.get<1>(), ',');
+      fields >> r.get<2>();
+      ++count;
+    }
+  }), n, text.size());
+  keep(count);
+
+  vector<char> data(text.begin(), text.end());
+  count = 0;
+  report_bytes("text_parser string", measure([&] {
+    text_parser parser(data.data(), data.data() + data.size());
+    row r;
+    while (parser.next(r)) ++count;
+  }), n, text.size());
+  keep(count);
+
+#if __cpp_lib_string_view
+  count = 0;
+  report_bytes("text_parser string_view", measure([&] {
+    text_parser parser(data.data(), data.data() + data.size());
+    tuple<int, std::string_view, double> r;
+    while (parser.next(r)) ++count;
+  }), n, text.size());
+  keep(count);
+#endif
+
+  count = 0;
+  report_bytes("text_parser 64k chunks", measure([&] {
+    text_parser parser;
+    row r;
+    for (std::size_t pos = 0; pos < text.size(); pos += 1 << 16) {
+      parser.feed(text.data() + pos, std::min<std::size_t>(1 << 16, text.size() - pos));
+      while (parser.next(r)) ++count;
+    }
+    parser.finish();
+    while (parser.next(r)) ++count;
+  }), n, text.size());
+  keep(count);
+
+  char name[] = "/tmp/tuple_bench_XXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0 || write(fd, text.data(), text.size()) != ssize_t(text.size())) return;
+
+  count = 0;
+  report_bytes("text_reader file", measure([&] {
+    lseek(fd, 0, SEEK_SET);
+    text_reader in(fd);
+    row r;
+    while (in.read(r)) ++count;
+  }), n, text.size());
+  keep(count);
+
+  count = 0;
+  report_bytes("mapped_file", measure([&] {
+    mapped_file file(name);
+    text_parser parser(file.data(), file.data() + file.size());
+    row r;
+    while (parser.next(r)) ++count;
+  }), n, text.size());
+  keep(count);
+
+  close(fd);
+  unlink(name);
+}
+
+//////////////////////// records
+
+void bench_records(std::size_t n) {
+  typedef tuple<int, string, double> row;
+  char name[] = "/tmp/tuple_bench_XXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0) return;
+
+  row r;
+  report("record_writer write", measure([&] {
+    record_writer out(fd);
+    for (std::size_t i = 0; i < n; ++i) {
+      r << int(i) | "name " + std::to_string(i % 1000) | i * 0.25;
+      out.write(r);
+    }
+  }), n);
+
+  double sum = 0;
+  report("record_file get<2> (lazy)", measure([&] {
+    record_file<row> file(name);
+    for (record_file<row>::iterator i = file.begin(); i != file.end(); ++i) sum += (*i).get<2>();
+  }), n);
+  keep(sum);
+
+  sum = 0;
+  report("record_file decode", measure([&] {
+    record_file<row> file(name);
+    for (record_file<row>::iterator i = file.begin(); i != file.end(); ++i) {
+      (*i).decode(r);
+      sum += r.get<2>();
+    }
+  }), n);
+  keep(sum);
+
+  close(fd);
+  unlink(name);
+}
+
+//////////////////////// hash map
+
+// the hasher one writes for std::unordered_map without tuple_hash
+struct legacy_hasher {
+  std::size_t operator()(const tuple<int, string>& t) const {
+    tuple<int, string>& r = const_cast<tuple<int, string>&>(t);
+    return std::hash<int>()(r.get<0>()) * 31 + std::hash<string>()(r.get<1>());
+  }
+};
+struct legacy_equal {
+  bool operator()(const tuple<int, string>& l, const tuple<int, string>& r) const { 
+    return tbd::tuple_details::eq(l, r);
+  }
+};
+
+void bench_map(std::size_t n) {
+  typedef tuple<int, string> key;
+  std::mt19937 random(11);
+  std::size_t groups = n / 8 + 1;
+  vector<key> keys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t g = random() % groups;
+    keys[i] << int(g) | "group " + std::to_string(g % 1000);
+  }
+
+  std::unordered_map<key, int, legacy_hasher, legacy_equal> std_map;
+  report("group by unordered_map", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) ++std_map[keys[i]];
+  }), n);
+
+  flat_map<key, int> map;
+  report("group by flat_map", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) ++map[keys[i]];
+  }), n);
+
+  long sum = 0;
+  report("find unordered_map", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += std_map.find(keys[i])->second;
+  }), n);
+  keep(sum);
+
+  sum = 0;
+  report("find flat_map", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += map.find(keys[i])->second;
+  }), n);
+  keep(sum);
+
+  sum = 0;
+  vector<flat_map<key, int>::const_iterator> found(n);
+  report("batch find flat_map", measure([&] {
+    map.find(keys.begin(), keys.end(), found.begin());
+    for (std::size_t i = 0; i < n; ++i) sum += found[i]->second;
+  }), n);
+  keep(sum);
+}
+
+//////////////////////// packed layout
+
+template<class Row> double scan(const vector<Row>& rows) {
+  double sum = 0;
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    Row& r = const_cast<Row&>(rows[i]);
+    sum += r.template get<1>() + r.template get<3>() + r.template get<0>();
+  }
+  return sum;
+}
+
+void bench_packed(std::size_t n) {
+  typedef tuple<char, double, char, double> row;
+  typedef packed_tuple<char, double, char, double> packed;
+  vector<row> rows(n);
+  vector<packed> packed_rows(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    rows[i] << char(i) | i * 0.5 | char(i >> 8) | i * 0.25;
+    packed_rows[i] << char(i) | i * 0.5 | char(i >> 8) | i * 0.25;
+  }
+  cout << "sizeof tuple<char, double, char, double>: " << sizeof(row) 
+       << ", packed: " << sizeof(packed) << endl;
+
+  double sum = 0;
+  report("scan vector<tuple>", measure([&] { sum += scan(rows); }), n);
+  report("scan vector<packed_tuple>", measure([&] { sum += scan(packed_rows); }), n);
+  keep(sum);
+}
+
+//////////////////////// batch accept
+
+// sums every element, with the runtime index of accept or the static one of visit
+struct column_sums {
+  long long sums[4];
+  column_sums() { for (int i = 0; i < 4; ++i) sums[i] = 0; }
+  template<class V> void operator() (const V& v, int i) { sums[i] += v; }
+  template<class V, std::size_t I> void operator() (const V& v, std::integral_constant<std::size_t, I>) { sums[I] += v; }
+  void merge(const column_sums& other) { for (int i = 0; i < 4; ++i) sums[i] += other.sums[i]; }
+  long long total() const { return sums[0] + sums[1] + sums[2] + sums[3]; }
+};
+
+void bench_batch(std::size_t n) {
+  typedef tuple<int, long long, short, int> row;
+  vector<row> rows(n);
+  for (std::size_t i = 0; i < n; ++i) rows[i] << int(i) | (long long)i * 3 | short(i % 7) | int(i % 1000);
+
+  column_sums by_row;
+  report("row by row accept", measure([&] { 
+    for (std::size_t i = 0; i < n; ++i) rows[i].accept(by_row); 
+  }), n);
+  keep(by_row.total());
+
+  column_sums visited;
+  report("row by row visit", measure([&] { 
+    for (std::size_t i = 0; i < n; ++i) rows[i].visit(visited); 
+  }), n);
+  keep(visited.total());
+
+  column_sums batch;
+  report("accept_batch", measure([&] { tbd::accept_batch(rows.begin(), rows.end(), batch); }), n);
+  keep(batch.total());
+
+  column_sums parallel;
+  report("parallel_accept", measure([&] { tbd::parallel_accept(rows.begin(), rows.end(), parallel); }), n);
+  keep(parallel.total());
+
+  tuple_table<int, long long, short, int> table;
+  table.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) table.push_back(rows[i]);
+
+  column_sums columns;
+  report("accept_batch tuple_table", measure([&] { tbd::accept_batch(table, columns); }), n);
+  keep(columns.total());
+
+  column_sums parallel_columns;
+  report("parallel_accept tuple_table", measure([&] { tbd::parallel_accept(table, parallel_columns); }), n);
+  keep(parallel_columns.total());
+}
+
+//////////////////////// projections
+
+void bench_select(std::size_t n) {
+  typedef tuple<string, int, double> row;
+  typedef tuple<double, string> key;
+  std::mt19937 random(5);
+  vector<row> rows;
+  rows.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    rows.push_back(accu << "customer/region/" + std::to_string(random() % 1000) | int(random() % 100) | double(random() % 64));
+  }
+
+  vector<row> sorted = rows;
+  report("sort by copied key <2, 0>", measure([&] {
+    std::sort(sorted.begin(), sorted.end(), [](const row& l, const row& r) { 
+      return key(accu << l.get<2>() | l.get<0>()) < key(accu << r.get<2>() | r.get<0>()); 
+    });
+  }), n);
+  keep(sorted.front().get<1>());
+
+  sorted = rows;
+  report("sort by select_less<2, 0>", measure([&] {
+    std::sort(sorted.begin(), sorted.end(), tbd::select_less<2, 0>());
+  }), n);
+  keep(sorted.front().get<1>());
+
+  sorted = rows;
+  report("sort by hand written get<2>, get<0>", measure([&] {
+    std::sort(sorted.begin(), sorted.end(), [](const row& l, const row& r) { 
+      return l.get<2>() < r.get<2>() || (!(r.get<2>() < l.get<2>()) && l.get<0>() < r.get<0>()); 
+    });
+  }), n);
+  keep(sorted.front().get<1>());
+
+  typedef tuple<int, string> group_key;
+  flat_map<group_key, int> copied;
+  report("group by copied key <1, 0>", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) ++copied[group_key(accu << rows[i].get<1>() | rows[i].get<0>())];
+  }), n);
+
+  flat_map<selection<const row, 1, 0>, int> selected;
+  report("group by select<1, 0>", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) ++selected[tbd::select<1, 0>(rows[i])];
+  }), n);
+  keep(copied.size() + selected.size());
+}
+
+//////////////////////// sorted index
+
+void bench_index(std::size_t n) {
+  typedef tuple<int, int, double> row;
+  typedef tuple<int, int> key;
+  std::mt19937 random(9);
+  int users = int(n / 16 + 1);
+  vector<row> rows(n);
+  for (std::size_t i = 0; i < n; ++i) rows[i] << int(random() % users) | int(i) | double(i % 100);
+  vector<key> lookups(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const row& r = rows[random() % n];
+    lookups[i] << r.get<0>() | r.get<1>();
+  }
+
+  std::map<key, double> map;
+  report("build std::map", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) map[key(accu << rows[i].get<0>() | rows[i].get<1>())] = rows[i].get<2>();
+  }), n);
+  tuple_index<row> index;
+  report("build tuple_index", measure([&] { index.assign(rows.begin(), rows.end()); }), n);
+
+  double sum = 0;
+  report("point lookup std::map", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += map.find(lookups[i])->second;
+  }), n);
+  report("point lookup tuple_index", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += index.find(lookups[i])->get<2>();
+  }), n);
+  report("point lookup std::lower_bound", measure([&] {
+    for (std::size_t i = 0; i < n; ++i) sum += std::lower_bound(index.begin(), index.end(), lookups[i])->get<2>();
+  }), n);
+
+  // all rows of a user, about 16
+  std::size_t queries = n / 8 + 1;
+  report("range lookup std::map", measure([&] {
+    for (std::size_t i = 0; i < queries; ++i) {
+      int user = lookups[i].get<0>();
+      std::map<key, double>::const_iterator last = map.lower_bound(key(accu << user + 1 | INT_MIN));
+      for (std::map<key, double>::const_iterator j = map.lower_bound(key(accu << user | INT_MIN)); j != last; ++j) sum += j->second;
+    }
+  }), queries);
+  report("range lookup tuple_index", measure([&] {
+    for (std::size_t i = 0; i < queries; ++i) {
+      std::pair<tuple_index<row>::const_iterator, tuple_index<row>::const_iterator> range = index.equal_range(accu << lookups[i].get<0>());
+      for (; range.first != range.second; ++range.first) sum += range.first->get<2>();
+    }
+  }), queries);
+  keep(sum);
+}
+
+//////////////////////// queues
+
+typedef tuple<int, long long, double> message;
+
+// the mutex protected std::deque the pipeline used before
+struct locked_queue {
+  void push(int i) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _messages.push_back(accu << i | (long long)i * 3 | i * 0.5);
+  }
+  long long pop() {
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_messages.empty()) {
+          long long v = _messages.front().get<1>();
+          _messages.pop_front();
+          return v;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+private:
+  std::mutex _mutex;
+  std::deque<message> _messages;
+};
+
+template<class Q> struct slot_queue {
+  explicit slot_queue(std::size_t capacity): _queue(capacity) {}
+  void push(int i) { _queue.push() << i | (long long)i * 3 | i * 0.5; }
+  long long pop() {
+    long long v;
+    _queue.pop() >> tbd::na | v | tbd::na;
+    return v;
+  }
+  Q _queue;
+};
+
+// producers and consumers move count messages, the batched queue claims up to 64 slots at once
+template<class Q> void produce(Q& q, int first, int count) { 
+  for (int i = first; i < first + count; ++i) q.push(i); 
+}
+template<class Q> long long consume(Q& q, int count) { 
+  long long sum = 0;
+  for (int i = 0; i < count; ++i) sum += q.pop();
+  return sum;
+}
+template<class Q> struct batch_queue {
+  explicit batch_queue(std::size_t capacity): _queue(capacity) {}
+  Q _queue;
+};
+template<class Q> void produce(batch_queue<Q>& q, int first, int count) {
+  for (int i = first; i < first + count;) {
+    typename Q::push_batch slots = q._queue.try_push(std::min(64, first + count - i));
+    for (std::size_t j = 0; j < slots.size(); ++j, ++i) slots[j] << i | (long long)i * 3 | i * 0.5;
+    if (slots.empty()) std::this_thread::yield();
+  }
+}
+template<class Q> long long consume(batch_queue<Q>& q, int count) {
+  long long sum = 0;
+  while (count) {
+    typename Q::pop_batch slots = q._queue.try_pop(std::min(64, count));
+    for (std::size_t j = 0; j < slots.size(); ++j) sum += slots[j].template get<1>();
+    count -= (int)slots.size();
+    if (slots.empty()) std::this_thread::yield();
+  }
+  return sum;
+}
+
+template<class Q> void pipeline(const char* name, Q& q, int producers, int consumers, std::size_t n) {
+  int per_producer = int(n / producers), per_consumer = per_producer * producers / consumers;
+  std::atomic<long long> sum(0);
+  report(name, measure([&] {
+    vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) threads.push_back(std::thread([&q, p, per_producer]() { produce(q, p * per_producer, per_producer); }));
+    for (int c = 0; c < consumers; ++c) threads.push_back(std::thread([&q, &sum, per_consumer]() { sum += consume(q, per_consumer); }));
+    for (std::size_t t = 0; t < threads.size(); ++t) threads[t].join();
+  }), per_producer * producers);
+  keep(sum.load());
+}
+
+// round trips of one message between two threads
+template<class Q> void ping_pong(const char* name, Q& ping, Q& pong, std::size_t n) {
+  report(name, measure([&] {
+    std::thread echo([&]() { for (std::size_t i = 0; i < n; ++i) pong.push(int(ping.pop())); });
+    for (std::size_t i = 0; i < n; ++i) {
+      ping.push(int(i));
+      pong.pop();
+    }
+    echo.join();
+  }), n);
+}
+
+void bench_queue(std::size_t n) {
+  std::size_t messages = n / 2 + 64, capacity = 1024;
+  {
+    locked_queue locked;
+    slot_queue<spsc_queue<message> > spsc(capacity);
+    batch_queue<spsc_queue<message> > spsc_batch(capacity);
+    slot_queue<mpmc_queue<message> > mpmc(capacity);
+    pipeline("1 -> 1 std::deque + mutex", locked, 1, 1, messages);
+    pipeline("1 -> 1 spsc_queue", spsc, 1, 1, messages);
+    pipeline("1 -> 1 spsc_queue batches", spsc_batch, 1, 1, messages);
+    pipeline("1 -> 1 mpmc_queue", mpmc, 1, 1, messages);
+  }
+  for (int threads = 2; threads <= 16; threads *= 2) {
+    int producers = threads / 2;
+    locked_queue locked;
+    slot_queue<mpmc_queue<message> > mpmc(capacity);
+    batch_queue<mpmc_queue<message> > mpmc_batch(capacity);
+    string suffix = std::to_string(producers) + " -> " + std::to_string(producers);
+    pipeline((suffix + " std::deque + mutex").c_str(), locked, producers, producers, messages);
+    pipeline((suffix + " mpmc_queue").c_str(), mpmc, producers, producers, messages);
+    pipeline((suffix + " mpmc_queue batches").c_str(), mpmc_batch, producers, producers, messages);
+  }
+
+  std::size_t trips = n / 100 + 1;
+  locked_queue locked_ping, locked_pong;
+  ping_pong("round trip std::deque + mutex", locked_ping, locked_pong, trips);
+  slot_queue<spsc_queue<message> > ping(capacity), pong(capacity);
+  ping_pong("round trip spsc_queue", ping, pong, trips);
+}
+
+//////////////////////// element iterators
+
+template<class Row> void iterate_rows(const char* name, std::size_t n) {
+  typedef typename Row::value_type items;
+  typedef tbd::tuple_details::iterator<items, double> input_iterator;
+  std::vector<Row> rows(n / Row::size + 1);
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    rows[i] << int(i) | 1.5f | 2.5 | long(i) | short(3) | 0.25 | 7 | 0.5f;
+  }
+  std::size_t elements = rows.size() * Row::size;
+  double buffer[8];
+  double sum = 0;
+
+  report((string(name) + " sum, input iterator").c_str(), measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      input_iterator end(rows[i].value(), Row::size);
+      for (input_iterator j(rows[i].value()); j != end; ++j) sum += *j;
+    }
+  }), elements);
+  report((string(name) + " sum, element_iterator").c_str(), measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      for (auto j = rows[i].template begin<double>(), end = rows[i].template end<double>(); j != end; ++j) sum += *j;
+    }
+  }), elements);
+  report((string(name) + " copy, input iterator").c_str(), measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      std::copy(input_iterator(rows[i].value()), input_iterator(rows[i].value(), Row::size), buffer);
+      sum += buffer[7];
+    }
+  }), elements);
+  report((string(name) + " copy, element_iterator").c_str(), measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      std::copy(rows[i].template begin<double>(), rows[i].template end<double>(), buffer);
+      sum += buffer[7];
+    }
+  }), elements);
+  report((string(name) + " 6th element, input iterator").c_str(), measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      input_iterator j(rows[i].value());
+      for (int k = 0; k < 5; ++k) ++j;
+      sum += *j;
+    }
+  }), rows.size());
+  report((string(name) + " 6th element, element_iterator").c_str(), measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) sum += rows[i].template begin<double>()[5];
+  }), rows.size());
+  keep(sum);
+}
+
+void bench_iterate(std::size_t n) {
+  iterate_rows<tuple<double, double, double, double, double, double, double, double> >("tuple<double x 8>", n);
+  iterate_rows<tuple<int, float, double, long, short, double, int, float> >("tuple<int, float, double, ...>", n);
+
+  typedef tuple<string, string, string, string> names;
+  typedef tbd::tuple_details::iterator<names::value_type, string> input_iterator;
+  std::vector<names> rows(n / names::size + 1, names(accu << string(24, 'a') | string(32, 'b') | "c" | string(40, 'd')));
+  std::size_t elements = rows.size() * names::size, length = 0;
+  report("tuple<string x 4> as string, input iterator", measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      input_iterator end(rows[i].value(), names::size);
+      for (input_iterator j(rows[i].value()); j != end; ++j) length += j->size();
+    }
+  }), elements);
+  report("tuple<string x 4> as string, element_iterator", measure([&] {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      for (auto j = rows[i].begin<string>(), end = rows[i].end<string>(); j != end; ++j) length += j->size();
+    }
+  }), elements);
+  keep(length);
+}
+
+//////////////////////// aggregate vs. get<C> loops
+
+void bench_aggregate(std::size_t n) {
+  typedef tuple<long long, double, float, int> row;
+  std::vector<row> rows(n);
+  std::mt19937 random(7);
+  for (std::size_t i = 0; i < n; ++i) rows[i] << (long long)random() | random() * 1e-6 | float(random() % 1000) | int(random() % 100000);
+  double sink = 0;
+
+  report("sum get<1> loop", measure([&] {
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += rows[i].get<1>();
+    sink += sum;
+  }), n);
+  report("aggregate<1> sum", measure([&] { sink += aggregate<1>(rows, tbd::aggregate_sum()).get<0>(); }), n);
+
+  report("min get<0, 1, 2, 3> loop", measure([&] {
+    long long m0 = LLONG_MAX;
+    double m1 = INFINITY;
+    float m2 = INFINITY;
+    int m3 = INT_MAX;
+    for (std::size_t i = 0; i < n; ++i) {
+      const row& r = rows[i];
+      m0 = std::min(m0, r.get<0>()); m1 = std::min(m1, r.get<1>()); m2 = std::min(m2, r.get<2>()); m3 = std::min(m3, r.get<3>());
+    }
+    sink += m0 + m1 + m2 + m3;
+  }), n);
+  report("aggregate<0, 1, 2, 3> min", measure([&] { 
+    sink += aggregate<0, 1, 2, 3>(rows, tbd::aggregate_min()).get<1>(); 
+  }), n);
+
+  report("mean get<0, 1, 2, 3> loop", measure([&] {
+    long long s0 = 0, s3 = 0;
+    double s1 = 0, s2 = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const row& r = rows[i];
+      s0 += r.get<0>(); s1 += r.get<1>(); s2 += r.get<2>(); s3 += r.get<3>();
+    }
+    sink += double(s0) / n + s1 / n + s2 / n + double(s3) / n;
+  }), n);
+  report("aggregate<0, 1, 2, 3> mean", measure([&] { 
+    sink += aggregate<0, 1, 2, 3>(rows, tbd::aggregate_mean()).get<2>(); 
+  }), n);
+  keep(sink);
+}
+
+//////////////////////// arena tuples vs. tuples
+
+// request scoped batches: rows are built from parsed text and dropped after
+// every batch, with a few distinct names (symbols, user agents, ...)
+template<class Row> void arena_batches(const char* name, const std::vector<string>& names, std::size_t n, bool use_arena) {
+  tbd::tuple_arena arena;
+  std::vector<Row> rows;
+  rows.reserve(1000);
+  std::size_t matches = 0;
+  report(name, measure([&] {
+    for (std::size_t done = 0; done < n; done += rows.size()) {
+      {
+        tbd::arena_scope scope(arena);
+        rows.clear();
+        for (std::size_t i = 0; i < 1000 && done + i < n; ++i) rows.push_back(accu << int(i) | names[i % names.size()] | 0.5);
+        for (std::size_t i = 1; i < rows.size(); ++i) matches += rows[i].template get<1>() == rows[i - 1].template get<1>();
+      }
+      if (use_arena) arena.release();
+    }
+  }), n);
+  keep(matches);
+}
+
+void bench_arena(std::size_t n) {
+  std::vector<string> names;
+  for (int i = 0; i < 16; ++i) names.push_back("customer name number " + std::to_string(i * 7919));
+  arena_batches<tuple<int, string, double> >("rows of tuple<int, string, double>", names, n, false);
+  arena_batches<tbd::arena_tuple<int, string, double> >("rows of arena_tuple<int, string, double>", names, n, true);
+  arena_batches<tuple<int, tbd::interned_string, double> >("rows of tuple<int, interned_string, double>", names, n, true);
+}
+
+// sorts rows (about four times the memory budget) through spilled runs
+void bench_external_sort(std::size_t n) {
+  typedef tuple<long long, string, double> row;
+  std::mt19937 random(11);
+  vector<row> rows(n);
+  std::size_t bytes = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    rows[i] << (long long)(random() % 100000) | "order/" + std::to_string(random()) + "/line" | double(random());
+    bytes += sizeof(row) + rows[i].get<1>().size();
+  }
+
+  vector<row> sorted = rows;
+  report("parallel_sort in memory", measure([&] { tbd::parallel_sort(sorted.begin(), sorted.end()); }), n);
+  keep(sorted.back().get<0>());
+
+  external_sort_config configs[2] = { external_sort_config(bytes / 4), external_sort_config(bytes / 16) };
+  configs[1].fan_in = 4;
+  const char* names[2] = { "external_sorter, memory = data / 4", "external_sorter, memory = data / 16, fan_in 4" };
+  for (int c = 0; c < 2; ++c) {
+    std::size_t runs = 0;
+    long long check = 0;
+    report(names[c], measure([&] {
+      external_sorter<row> sorter(configs[c]);
+      for (std::size_t i = 0; i < n; ++i) sorter.push(rows[i]);
+      for (row r; sorter.next(r); ) check += r.get<0>();
+      runs = sorter.runs();
+    }), n);
+    cout << "  " << runs << " run files" << endl;
+    keep(check);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], 0, 10) : 2000000;
+
+  bench_table(n);
+  bench_sort(n);
+  bench_get_runtime(n);
+  bench_convert(n);
+  bench_join(n);
+  bench_parse(n);
+  bench_records(n);
+  bench_map(n);
+  bench_packed(n);
+  bench_batch(n);
+  bench_select(n);
+  bench_index(n);
+  bench_queue(n);
+  bench_iterate(n);
+  bench_arena(n);
+  bench_aggregate(n);
+  bench_external_sort(n);
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Compile time benchmark: generates translation units that build, compare, 
+# read and write tuples of 2 to SIZE elements and times compiling them.
+#
+#   ./tuple_compile_bench.sh [include dir] [units] [size]
+#
+# Run it once per tuple.h to compare (e.g. a checkout of an older version).
+# Extra flags are taken from CXXFLAGS, clang users may add -ftime-trace.
+
+DIR=${1:-.}
+UNITS=${2:-20}
+SIZE=${3:-10}
+CXX=${CXX:-c++}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+types() {
+  i=0
+  while [ $i -lt $1 ]; do
+    case $((i % 4)) in
+      0) printf 'int' ;; 1) printf 'double' ;; 2) printf 'std::string' ;; 3) printf 'long' ;;
+    esac
+    i=$((i + 1))
+    [ $i -lt $1 ] && printf ', '
+  done
+}
+
+values() {
+  i=0
+  while [ $i -lt $1 ]; do
+    case $((i % 4)) in
+      0) printf '%d' $((i + $2)) ;; 1) printf '%d.5' $i ;; 2) printf '"s%d"' $i ;; 3) printf '%dL' $i ;;
+    esac
+    i=$((i + 1))
+    [ $i -lt $1 ] && printf ' | '
+  done
+}
+
+u=0
+while [ $u -lt $UNITS ]; do
+  f="$WORK/unit$u.cc"
+  echo '#include "tuple.h"' > "$f"
+  echo "namespace unit$u {" >> "$f"
+  n=2
+  while [ $n -le $SIZE ]; do
+    cat >> "$f" <<UNIT
+typedef tbd::tuple<$(types $n)> row$n;
+bool use$n(row$n& a) {
+  row$n b(tbd::accu << $(values $n $u));
+  int first;
+  b >> first;
+  a.set<0>(first);
+  a.set<$((n - 1))>(b.get<$((n - 1))>());
+  return a < b || a == b;
+}
+UNIT
+    n=$((n + 1))
+  done
+  echo "}" >> "$f"
+  u=$((u + 1))
+done
+
+start=$(date +%s.%N)
+for f in "$WORK"/*.cc; do
+  $CXX -std=c++11 -D__int64="long long" $CXXFLAGS -I"$DIR" -c "$f" -o "$f.o" || exit 1
+done
+end=$(date +%s.%N)
+echo "$UNITS units with tuples of 2 - $SIZE elements: $(awk "BEGIN { print $end - $start }") s"
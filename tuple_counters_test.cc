@@ -0,0 +1,106 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+#include <thread>
+#include <typeinfo>
+
+#define TBD_TUPLE_INSTRUMENT 1
+#include "tuple.h"
+using tbd::accu;
+using tbd::tuple;
+
+static std::size_t exported = 0;
+static std::size_t exported_copies = 0;
+
+void export_counters(const tbd::tuple_counters& c) {
+  ++exported;
+  exported_copies += c.copies;
+}
+
+std::size_t conversions(const tbd::tuple_counters& c, const std::type_info& from, const std::type_info& to) {
+  for (std::size_t i = 0; i < c.by_type.size(); ++i) {
+    if (*c.by_type[i].from == from && *c.by_type[i].to == to) return c.by_type[i].count;
+  }
+  return 0;
+}
+
+int main() {
+  typedef tuple<int, string, double> row;
+  tbd::reset_counters();
+
+  // builders copy lvalues and move rvalues, each element once
+  string name("seven");
+  row r(accu << 7 | name | 0.5);
+  tbd::tuple_counters c = tbd::counters();
+  assert(c.copies == 1 && c.moves == 2);
+
+  // << and >> copy every element once
+  tbd::reset_counters();
+  int i = 0;
+  double d = 0.5;
+  r << 8 | name | d;
+  r >> i | name | d;
+  c = tbd::counters();
+  assert(c.copies == 5 && c.moves == 1);
+
+  // | copies the prefix of an lvalue tuple
+  tbd::reset_counters();
+  tuple<int, double> p(accu << 1 | 2.0);
+  tbd::reset_counters();
+  tuple<int, double, int> q = p | 3;
+  c = tbd::counters();
+  assert(c.copies == 2 && c.moves == 1 && q.get<2>() == 3);
+
+  // comparisons count the visited element pairs
+  tbd::reset_counters();
+  row other(r);
+  other.set<2>(1.5);
+  tbd::reset_counters();
+  assert(r < other && r != other);
+  c = tbd::counters();
+  assert(c.comparisons == 6 && c.copies == 0);
+
+  // conversions by type, streams for anything without a direct conversion
+  tbd::reset_counters();
+  assert(r.get<string>(0) == "8" && r.get<int>(2) == 0 && r.get<int>(1) == 0);
+  c = tbd::counters();
+  assert(c.conversions == 3 && c.by_type.size() == 3);
+  assert(conversions(c, typeid(int), typeid(string)) == 1);
+  assert(conversions(c, typeid(double), typeid(int)) == 1);
+  assert(conversions(c, typeid(string), typeid(int)) == 1);
+#if !TBD_TUPLE_HAS_CHARCONV
+  assert(c.streams == 2);
+#endif
+
+  // join counts formatted elements
+  tbd::reset_counters();
+  assert(r.join(",") == "8,seven,0.5");
+  assert(tbd::counters().formats == 3);
+
+  // reset clears everything, flush hands the counters to the hook
+  tbd::reset_counters();
+  c = tbd::counters();
+  assert(!c.copies && !c.moves && !c.conversions && !c.formats && !c.comparisons && c.by_type.empty());
+  assert(tbd::set_counters_hook(export_counters) == 0);
+  r << 1 | "one" | 1.0;
+  tbd::flush_counters();
+  assert(exported == 1 && exported_copies == 1 && tbd::counters().moves == 0);
+
+  // counters are per thread, exiting threads report to the hook
+  std::thread t([] { 
+    row x(accu << 1 | string("x") | 2.0);
+    tuple<int> y(accu << x.get<0>());
+    assert(tbd::counters().copies == 1);
+  });
+  t.join();
+  assert(exported == 2 && exported_copies == 2 && tbd::counters().copies == 0);
+  assert(tbd::set_counters_hook(0) == export_counters);
+
+  cout << "instrumented: " << r.join(", ") << endl;
+  return 0;
+}
@@ -0,0 +1,183 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+#ifndef __tuple_index_h__
+#define __tuple_index_h__
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tuple.h"
+#include "tuple_select.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// prefix comparison
+
+// compare_prefix compares only as many elements as the key has, a row that
+// starts with the key compares equal. Rows matching a prefix are a range in
+// sorted order because compare() puts a shorter tuple before every longer 
+// tuple that matches it so far.
+
+inline int compare_prefix(const tuple_end&, const tuple_end&) { return 0; }
+template<class T> int compare_prefix(const T&, const tuple_end&) { return 0; }
+template<class K> int compare_prefix(const tuple_end&, const K&) { return -1; }
+template<class T, class K> int compare_prefix(const T& row, const K& key) {
+  int c = compare_values(row.head(), key.head());
+  return c ? c : compare_prefix(row.tail(), key.tail());
+}
+
+// head() / tail() over the values of a builder, so accu << a | b works as 
+// a key without building a tuple
+template<class B, std::size_t C> struct builder_items {
+  enum { size = B::size - C };
+  typedef typename std::remove_reference<decltype(builder_element<C>(std::declval<const B&>()))>::type head_type;
+  typedef typename std::conditional<C + 1 == B::size, tuple_end, builder_items<B, C + 1> >::type tail_type;
+
+  explicit builder_items(const B& b): _builder(b) {}
+
+  const head_type& head() const { return builder_element<C>(_builder); }
+  tail_type tail() const { return make_tail(std::integral_constant<bool, C + 1 == B::size>()); }
+private:
+  tuple_end make_tail(std::true_type) const { return tuple_end(); }
+  tail_type make_tail(std::false_type) const { return tail_type(_builder); }
+
+  const B& _builder;
+};
+
+template<class HT, class TT> const tuple_item<HT, TT>& index_key(const tuple_item<HT, TT>& key) { return key; }
+template<class T, int... I> const select_item<T, I...>& index_key(const selection<T, I...>& key) { return key.value(); }
+template<class P, class V> builder_items<tuple_builder<P, V>, 0> index_key(const tuple_builder<P, V>& key) { 
+  return builder_items<tuple_builder<P, V>, 0>(key); 
+}
+
+//////////////////////// tuple_index
+
+// A static sorted index over tuples. The rows are kept sorted in one array,
+// so ranges are scanned sequentially. The first row of every block of B 
+// rows is copied into a separate array in Eytzinger (breadth first) order: 
+// a lookup walks down this implicit binary tree, whose top levels stay in 
+// the cache, and finishes with a binary search inside a single block.
+// Keys are tuples, selections or builders (accu << user_id) and may be a 
+// prefix of the rows. The index is built at once (bulk load) and rebuilt 
+// with assign() - there are no single inserts.
+
+template<class T, std::size_t B = 16> struct tuple_index {
+  typedef T value_type;
+  typedef typename std::vector<T>::const_iterator const_iterator;
+  typedef const_iterator iterator;
+
+  tuple_index() {}
+  template<class It> tuple_index(It first, It last) { assign(first, last); }
+  explicit tuple_index(std::vector<T>&& rows) { assign(std::move(rows)); }
+
+  // sorts the rows and builds the separators
+  template<class It> void assign(It first, It last) { assign(std::vector<T>(first, last)); }
+  void assign(std::vector<T>&& rows) {
+    _rows = std::move(rows);
+    std::sort(_rows.begin(), _rows.end());
+    build();
+  }
+
+  std::size_t size() const { return _rows.size(); }
+  bool empty() const { return _rows.empty(); }
+  const_iterator begin() const { return _rows.begin(); }
+  const_iterator end() const { return _rows.end(); }
+  const T& operator[](std::size_t i) const { return _rows[i]; }
+
+  // the first row not less than key
+  template<class K> const_iterator lower_bound(const K& key) const { return begin() + bound(index_key(key), 0); }
+  // the first row greater than key (and not starting with it)
+  template<class K> const_iterator upper_bound(const K& key) const { return begin() + bound(index_key(key), 1); }
+  // all rows starting with key
+  template<class K> std::pair<const_iterator, const_iterator> equal_range(const K& key) const {
+    std::size_t first = bound(index_key(key), 0), last = first;
+    while (last < _rows.size() && last - first < B && compare_prefix(_rows[last], index_key(key)) == 0) ++last;
+    if (last - first == B) last = bound(index_key(key), 1);
+    return std::make_pair(begin() + first, begin() + last);
+  }
+  // the first row starting with key or end()
+  template<class K> const_iterator find(const K& key) const {
+    std::size_t i = bound(index_key(key), 0);
+    return i < _rows.size() && compare_prefix(_rows[i], index_key(key)) == 0 ? begin() + i : end();
+  }
+  template<class K> std::size_t count(const K& key) const { 
+    std::pair<const_iterator, const_iterator> r = equal_range(key);
+    return r.second - r.first; 
+  }
+
+private:
+  // the number of leading rows with compare_prefix(row, key) < limit
+  template<class K> std::size_t bound(const K& key, int limit) const {
+    std::size_t n = _separators.size(), k = 1;
+    while (k <= n) k = 2 * k + (compare_prefix(_separators[k - 1], key) < limit);
+    // the last step to the right was at the answer, 0 if there was none
+    while (k & 1) k >>= 1;
+    k >>= 1;
+
+    std::size_t block = k ? _blocks[k - 1] : n;
+    if (block == 0) return 0;
+    std::size_t first = (block - 1) * B + 1, last = std::min(block * B, _rows.size());
+    while (first < last) {
+      std::size_t middle = first + (last - first) / 2;
+      if (compare_prefix(_rows[middle], key) < limit) first = middle + 1;
+      else last = middle;
+    }
+    return first;
+  }
+
+  void build() {
+    std::size_t n = (_rows.size() + B - 1) / B;
+    _separators.assign(n, T());
+    _blocks.assign(n, 0);
+    std::size_t block = 0;
+    layout(1, block);
+  }
+  // in order walk of the implicit tree assigns the blocks in sorted order
+  void layout(std::size_t k, std::size_t& block) {
+    if (k > _separators.size()) return;
+    layout(2 * k, block);
+    _separators[k - 1] = _rows[block * B];
+    _blocks[k - 1] = block++;
+    layout(2 * k + 1, block);
+  }
+
+  std::vector<T> _rows;
+  std::vector<T> _separators;
+  std::vector<std::size_t> _blocks;
+};
+
+} // namespace tuple_details
+
+// lifting the index to tbd namespace
+using tuple_details::tuple_index;
+using tuple_details::compare_prefix;
+
+} // namspace tbd
+
+#endif // __tuple_index_h__
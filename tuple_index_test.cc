@@ -0,0 +1,78 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+#include "tuple_index.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::tuple_index;
+
+typedef tuple<int, int, string> row;
+typedef tuple_index<row, 4> index_type;
+
+int main() {
+  // prefixes compare equal, shorter keys come first
+  row r(accu << 3 | 7 | "x");
+  assert(tbd::compare_prefix(r, tuple<int>(accu << 3)) == 0);
+  assert(tbd::compare_prefix(r, tuple<int, int>(accu << 3 | 8)) < 0);
+  assert(tbd::compare_prefix(r, tuple<int>(accu << 2)) > 0);
+  assert(tbd::compare_prefix(r, r) == 0);
+
+  // bulk load from unsorted rows, every size around the block boundaries
+  std::mt19937 random(3);
+  for (int n = 0; n < 70; ++n) {
+    vector<row> rows;
+    for (int i = 0; i < n; ++i) rows.push_back(accu << int(random() % 8) | int(random() % 4) | std::to_string(i));
+    index_type index(rows.begin(), rows.end());
+    assert(index.size() == rows.size() && std::is_sorted(index.begin(), index.end()));
+    std::sort(rows.begin(), rows.end());
+
+    for (int user = -1; user < 9; ++user) {
+      tuple<int> key(accu << user);
+      vector<row>::iterator first = std::lower_bound(rows.begin(), rows.end(), key);
+      vector<row>::iterator last = std::lower_bound(rows.begin(), rows.end(), tuple<int>(accu << user + 1));
+      assert(index.lower_bound(key) - index.begin() == first - rows.begin());
+      assert(index.upper_bound(accu << user) - index.begin() == last - rows.begin());
+      assert(index.equal_range(accu << user).first - index.begin() == first - rows.begin());
+      assert(index.equal_range(key).second - index.begin() == last - rows.begin());
+      assert(index.count(key) == std::size_t(last - first));
+      assert((index.find(key) == index.end()) == (first == last));
+
+      for (int time = 0; time < 4; ++time) {
+        int expected = 0;
+        for (std::size_t i = 0; i < rows.size(); ++i) expected += rows[i].get<0>() == user && rows[i].get<1>() == time;
+        assert(index.count(accu << user | time) == std::size_t(expected));
+      }
+    }
+    // full rows are found exactly
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      assert(*index.find(rows[i]) == rows[i] && *index.lower_bound(rows[i]) == rows[i]);
+      assert(index.count(rows[i]) == 1);
+    }
+  }
+
+  // a long run of equal prefixes and a selection as key
+  vector<row> same;
+  for (int i = 0; i < 100; ++i) same.push_back(accu << i % 2 | i | "s");
+  index_type index(std::move(same));
+  assert(index.count(accu << 1) == 50 && index.count(accu << 0) == 50 && index.count(accu << 2) == 0);
+  tuple<string, int> other(accu << "t" | 1);
+  assert(index.count(tbd::select<1>(other)) == 50);
+  assert(index.equal_range(accu << 1).first->get<1>() == 1);
+
+  tuple_index<row> empty;
+  assert(empty.lower_bound(accu << 1) == empty.end() && empty.count(accu << 1) == 0);
+
+  cout << "user 1: " << index.count(accu << 1) << " rows" << endl;
+  return 0;
+}
@@ -0,0 +1,319 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+#ifndef __tuple_map_h__
+#define __tuple_map_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+#include "tuple.h"
+
+#if defined(_MSC_VER)
+#  include <xmmintrin.h>
+#endif
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// flat_table
+
+// An open addressing hash table with linear probing. Every slot stores the 
+// hash of its value next to it (0 marks an empty slot), a lookup compares 
+// the stored hashes first and calls Equal only if they match. Erase shifts
+// the following values back instead of leaving tombstones, so lookups never
+// get slower after erasing.
+
+struct tuple_equal {
+  template<class T1, class T2> bool operator()(const T1& l, const T2& r) const { return eq(l, r); }
+};
+
+inline void prefetch(const void* p) {
+#if defined(__GNUC__)
+  __builtin_prefetch(p);
+#elif defined(_MSC_VER)
+  _mm_prefetch((const char*)p, _MM_HINT_T0);
+#else
+  (void)p;
+#endif
+}
+
+template<class K, class V> struct map_slot {
+  typedef K key_type;
+  typedef std::pair<K, V> value_type;
+  static const K& key(const value_type& v) { return v.first; }
+};
+
+template<class K> struct set_slot {
+  typedef K key_type;
+  typedef K value_type;
+  static const K& key(const value_type& v) { return v; }
+};
+
+template<class Slot, class Hash, class Equal> class flat_table {
+public:
+  typedef typename Slot::key_type key_type;
+  typedef typename Slot::value_type value_type;
+  enum { batch_size = 16 };
+
+  struct entry {
+    std::size_t hash;
+    value_type value;
+  };
+
+  template<class E, class R> struct basic_iterator {
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename flat_table::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef R* pointer;
+    typedef R& reference;
+
+    basic_iterator(): _entry(0), _end(0) {}
+    basic_iterator(E* e, E* end): _entry(e), _end(end) { skip(); }
+    template<class E2, class R2> basic_iterator(const basic_iterator<E2, R2>& i): _entry(i._entry), _end(i._end) {}
+
+    R& operator*() const { return _entry->value; }
+    R* operator->() const { return &_entry->value; }
+    basic_iterator& operator++() { ++_entry; skip(); return *this; }
+    basic_iterator operator++(int) { basic_iterator i(*this); ++*this; return i; }
+    template<class E2, class R2> bool operator==(const basic_iterator<E2, R2>& i) const { return _entry == i._entry; }
+    template<class E2, class R2> bool operator!=(const basic_iterator<E2, R2>& i) const { return _entry != i._entry; }
+
+    void skip() { while (_entry != _end && !_entry->hash) ++_entry; }
+
+    E* _entry;
+    E* _end;
+  };
+  typedef basic_iterator<entry, value_type> iterator;
+  typedef basic_iterator<const entry, const value_type> const_iterator;
+
+  flat_table(std::size_t capacity = 0, const Hash& hash = Hash(), const Equal& equal = Equal()): 
+    _entries(0), _mask(0), _size(0), _hash(hash), _equal(equal) { reserve(capacity); }
+  flat_table(const flat_table& t): _entries(0), _mask(0), _size(0), _hash(t._hash), _equal(t._equal) {
+    reserve(t._size);
+    for (const_iterator i = t.begin(); i != t.end(); ++i) insert(*i);
+  }
+  flat_table(flat_table&& t): _entries(t._entries), _mask(t._mask), _size(t._size), _hash(t._hash), _equal(t._equal) {
+    t._entries = 0;
+    t._mask = t._size = 0;
+  }
+  ~flat_table() { release(); }
+
+  flat_table& operator= (flat_table t) { 
+    std::swap(_entries, t._entries);
+    std::swap(_mask, t._mask);
+    std::swap(_size, t._size);
+    std::swap(_hash, t._hash);
+    std::swap(_equal, t._equal);
+    return *this;
+  }
+
+  std::size_t size() const { return _size; }
+  bool empty() const { return !_size; }
+  std::size_t capacity() const { return _entries ? _mask + 1 : 0; }
+
+  iterator begin() { return iterator(_entries, _entries + capacity()); }
+  iterator end() { return iterator(_entries + capacity(), _entries + capacity()); }
+  const_iterator begin() const { return const_iterator(_entries, _entries + capacity()); }
+  const_iterator end() const { return const_iterator(_entries + capacity(), _entries + capacity()); }
+
+  void clear() {
+    for (std::size_t i = 0; i < capacity(); ++i) {
+      if (_entries[i].hash) destroy(_entries[i]);
+    }
+    _size = 0;
+  }
+
+  // makes room for n values without growing (the load factor stays below 3/4)
+  void reserve(std::size_t n) {
+    std::size_t c = 16;
+    while (c - c / 4 < n) c *= 2;
+    if (c > capacity()) rehash(c);
+  }
+
+  template<class K> iterator find(const K& key) { 
+    return iterator(lookup(key, hash_of(key)), _entries + capacity()); 
+  }
+  template<class K> const_iterator find(const K& key) const { 
+    return const_iterator(lookup(key, hash_of(key)), _entries + capacity()); 
+  }
+  template<class K> std::size_t count(const K& key) const { return find(key) != end(); }
+
+  // looks up all keys in [first, last) and writes an iterator for each of 
+  // them to out. The hashes of a batch are computed first and their slots
+  // prefetched, so the cache misses of the batch overlap.
+  template<class KeyIt, class OutIt> OutIt find(KeyIt first, KeyIt last, OutIt out) const {
+    std::size_t hashes[batch_size];
+    KeyIt keys[batch_size];
+    while (first != last) {
+      int n = 0;
+      for (; n < batch_size && first != last; ++n, ++first) {
+        keys[n] = first;
+        hashes[n] = hash_of(*first);
+        if (_entries) prefetch(_entries + (hashes[n] & _mask));
+      }
+      for (int i = 0; i < n; ++i) {
+        *out++ = const_iterator(lookup(*keys[i], hashes[i]), _entries + capacity());
+      }
+    }
+    return out;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& v) { return emplace(Slot::key(v), v); }
+  std::pair<iterator, bool> insert(value_type&& v) { 
+    const key_type& k = Slot::key(v);
+    return emplace(k, std::move(v)); 
+  }
+
+  // inserts a value constructed from args if key is not in the table yet
+  template<class K, class... Args> std::pair<iterator, bool> emplace(const K& key, Args&&... args) {
+    std::size_t h = hash_of(key);
+    if (entry* e = lookup(key, h)) {
+      if (e != _entries + capacity()) return std::make_pair(iterator(e, _entries + capacity()), false);
+    }
+    if (_size + 1 > capacity() - capacity() / 4) reserve(_size + 1);
+    entry* e = _entries + (h & _mask);
+    while (e->hash) e = next(e);
+    new (&e->value) value_type(std::forward<Args>(args)...);
+    e->hash = h;
+    ++_size;
+    return std::make_pair(iterator(e, _entries + capacity()), true);
+  }
+
+  template<class K> std::size_t erase(const K& key) {
+    entry* e = lookup(key, hash_of(key));
+    if (e == _entries + capacity()) return 0;
+    erase(e);
+    return 1;
+  }
+  void erase(const_iterator i) { erase(const_cast<entry*>(i._entry)); }
+
+private:
+  template<class K> std::size_t hash_of(const K& key) const {
+    // the top bit marks a used slot, the index uses the low bits
+    return (std::size_t)_hash(key) | ~(~std::size_t(0) >> 1);
+  }
+
+  entry* next(entry* e) const { return e == _entries + _mask ? _entries : e + 1; }
+
+  // the entry holding key or end
+  template<class K> entry* lookup(const K& key, std::size_t h) const {
+    if (!_entries) return 0;
+    for (entry* e = _entries + (h & _mask); e->hash; e = next(e)) {
+      if (e->hash == h && _equal(Slot::key(e->value), key)) return e;
+    }
+    return _entries + capacity();
+  }
+
+  void erase(entry* e) {
+    destroy(*e);
+    --_size;
+    // moves every following entry whose home slot is not between the hole 
+    // and itself into the hole
+    entry* hole = e;
+    for (entry* i = next(e); i->hash; i = next(i)) {
+      std::size_t home = i->hash & _mask, h = hole - _entries, at = i - _entries;
+      bool stays = h <= at ? (h < home && home <= at) : (h < home || home <= at);
+      if (stays) continue;
+      new (&hole->value) value_type(std::move(i->value));
+      hole->hash = i->hash;
+      destroy(*i);
+      hole = i;
+    }
+  }
+
+  void destroy(entry& e) {
+    e.value.~value_type();
+    e.hash = 0;
+  }
+
+  void rehash(std::size_t c) {
+    entry* old = _entries;
+    std::size_t old_capacity = capacity();
+    _entries = static_cast<entry*>(::operator new(c * sizeof(entry)));
+    _mask = c - 1;
+    for (std::size_t i = 0; i < c; ++i) _entries[i].hash = 0;
+    for (std::size_t i = 0; i < old_capacity; ++i) {
+      if (!old[i].hash) continue;
+      entry* e = _entries + (old[i].hash & _mask);
+      while (e->hash) e = next(e);
+      new (&e->value) value_type(std::move(old[i].value));
+      e->hash = old[i].hash;
+      old[i].value.~value_type();
+    }
+    ::operator delete(old);
+  }
+
+  void release() {
+    clear();
+    ::operator delete(_entries);
+    _entries = 0;
+    _mask = 0;
+  }
+
+  entry* _entries;
+  std::size_t _mask;
+  std::size_t _size;
+  Hash _hash;
+  Equal _equal;
+};
+
+//////////////////////// flat_map / flat_set
+
+template<class K, class V, class Hash = tuple_hash, class Equal = tuple_equal> 
+struct flat_map : flat_table<map_slot<K, V>, Hash, Equal> {
+  typedef flat_table<map_slot<K, V>, Hash, Equal> table_type;
+  typedef V mapped_type;
+
+  flat_map(std::size_t capacity = 0, const Hash& hash = Hash(), const Equal& equal = Equal()): 
+    table_type(capacity, hash, equal) {}
+
+  using table_type::emplace;
+  using table_type::insert;
+
+  V& operator[](const K& key) {
+    return emplace(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()).first->second;
+  }
+};
+
+template<class K, class Hash = tuple_hash, class Equal = tuple_equal> 
+struct flat_set : flat_table<set_slot<K>, Hash, Equal> {
+  typedef flat_table<set_slot<K>, Hash, Equal> table_type;
+
+  flat_set(std::size_t capacity = 0, const Hash& hash = Hash(), const Equal& equal = Equal()): 
+    table_type(capacity, hash, equal) {}
+};
+
+} // namespace tuple_details
+
+// lifting the tables to tbd namespace
+using tuple_details::tuple_equal;
+using tuple_details::flat_map;
+using tuple_details::flat_set;
+
+} // namspace tbd
+
+#endif // __tuple_map_h__
@@ -0,0 +1,95 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <cassert>
+#include <set>
+#include <unordered_map>
+
+#include "tuple_map.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::flat_map;
+using tbd::flat_set;
+
+typedef tuple<int, string> key;
+
+key make_key(int i) { return accu << i | "key " + std::to_string(i % 100); }
+
+int main() {
+  // equal tuples hash equal, also nested and as std::unordered_map key
+  assert(tbd::hash(make_key(7)) == tbd::hash(make_key(7)));
+  assert(tbd::hash(make_key(7)) != tbd::hash(make_key(8)));
+  tuple<key, double> nested = accu << make_key(7) | 1.5;
+  assert(tbd::hash(nested) == tbd::hash(tuple<key, double>(accu << make_key(7) | 1.5)));
+
+  std::unordered_map<key, int> std_map;
+  std_map[make_key(1)] = 1;
+  assert(std_map.count(make_key(1)) == 1 && std_map.count(make_key(2)) == 0);
+
+  // small ints spread over the low bits
+  std::set<std::size_t> buckets;
+  for (int i = 0; i < 1024; ++i) buckets.insert(tbd::hash(tuple<int, int>(accu << i | 0)) & 1023);
+  assert(buckets.size() > 600);
+
+  // insert, find, count
+  const int n = 10000;
+  flat_map<key, int> map;
+  for (int i = 0; i < n; ++i) assert(map.insert(std::make_pair(make_key(i), i)).second);
+  assert(!map.insert(std::make_pair(make_key(5), 0)).second);
+  assert(map.size() == n && map.capacity() - map.capacity() / 4 >= map.size());
+  for (int i = 0; i < n; ++i) assert(map.find(make_key(i))->second == i);
+  assert(map.find(make_key(n)) == map.end());
+  assert(map.count(make_key(n - 1)) == 1);
+
+  // group by
+  flat_map<tuple<int, int>, int> groups;
+  for (int i = 0; i < n; ++i) ++groups[accu << i % 10 | i % 7];
+  assert(groups.size() == 70);
+  int total = 0;
+  for (flat_map<tuple<int, int>, int>::iterator i = groups.begin(); i != groups.end(); ++i) total += i->second;
+  assert(total == n);
+
+  // erase every other key, the rest stays reachable
+  for (int i = 0; i < n; i += 2) assert(map.erase(make_key(i)) == 1);
+  assert(map.erase(make_key(0)) == 0);
+  assert(map.size() == n / 2);
+  for (int i = 0; i < n; ++i) assert(map.count(make_key(i)) == (std::size_t)(i % 2));
+  std::size_t visited = 0;
+  for (flat_map<key, int>::const_iterator i = map.begin(); i != map.end(); ++i) ++visited;
+  assert(visited == map.size());
+
+  // batch lookup gives the same result as single lookups
+  vector<key> keys;
+  for (int i = 0; i < 100; ++i) keys.push_back(make_key(i * 3));
+  vector<flat_map<key, int>::const_iterator> found;
+  map.find(keys.begin(), keys.end(), std::back_inserter(found));
+  assert(found.size() == keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    assert(found[i] == map.find(keys[i]));
+  }
+
+  // copies are independent, moves leave an empty table
+  flat_map<key, int> copy(map);
+  copy.erase(make_key(1));
+  assert(copy.size() + 1 == map.size() && map.count(make_key(1)));
+  flat_map<key, int> moved(std::move(copy));
+  assert(moved.size() + 1 == map.size() && copy.empty() && copy.find(make_key(3)) == copy.end());
+  copy = map;
+  assert(copy.size() == map.size());
+  map.clear();
+  assert(map.empty() && map.find(make_key(1)) == map.end() && copy.count(make_key(1)));
+
+  flat_set<key> set;
+  assert(set.insert(make_key(1)).second && !set.insert(make_key(1)).second);
+  assert(set.count(make_key(1)) && !set.count(make_key(2)));
+  
+  cout << "hashed " << n << " keys" << endl;
+  return 0;
+}
@@ -0,0 +1,406 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+
+#ifndef __tuple_merge_h__
+#define __tuple_merge_h__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "tuple.h"
+#include "tuple_record.h"
+#include "tuple_sort.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// loser_tree
+
+// Picks the smallest current element of k sources with log2(k) compares 
+// per element: every inner node keeps the loser of the match below it and
+// only the path of the source that moved on is replayed. Equal elements 
+// are taken from the source with the lower index first. A Source has 
+// done() and current().
+template<class Source, class Less> struct loser_tree {
+  loser_tree(std::vector<Source>& sources, Less less): 
+    _sources(sources), _less(less), _nodes(sources.size()) {
+    if (!_nodes.empty()) _nodes[0] = build(1);
+  }
+
+  // index of the source with the smallest element, size() once all are done
+  std::size_t top() const { 
+    return _nodes.empty() || _sources[_nodes[0]].done() ? _sources.size() : _nodes[0]; 
+  }
+
+  // call after the top source moved on
+  void replay() {
+    std::size_t winner = _nodes[0];
+    for (std::size_t n = (winner + _nodes.size()) / 2; n > 0; n /= 2) {
+      if (beats(_nodes[n], winner)) std::swap(_nodes[n], winner);
+    }
+    _nodes[0] = winner;
+  }
+
+private:
+  // leaves are the nodes k ... 2k - 1, returns the winner below n
+  std::size_t build(std::size_t n) {
+    if (n >= _nodes.size()) return n - _nodes.size();
+    std::size_t a = build(2 * n), b = build(2 * n + 1);
+    if (beats(b, a)) std::swap(a, b);
+    _nodes[n] = b;
+    return a;
+  }
+  bool beats(std::size_t a, std::size_t b) const {
+    if (_sources[a].done()) return false;
+    if (_sources[b].done()) return true;
+    if (_less(_sources[a].current(), _sources[b].current())) return true;
+    if (_less(_sources[b].current(), _sources[a].current())) return false;
+    return a < b;
+  }
+
+  std::vector<Source>& _sources;
+  Less _less;
+  std::vector<std::size_t> _nodes; // 0 is the winner, 1 ... k - 1 losers
+};
+
+//////////////////////// merge_run
+
+// A sorted run: a record file written by record_writer (mapped and decoded 
+// row by row) or rows in memory. good() is false if the file could not be
+// mapped or a record not decoded, the run ends there.
+template<class T> struct merge_run {
+  typedef record_file<T> file_type;
+
+  explicit merge_run(const char* path): _file(new file_type(path)), 
+    _pos(_file->begin()), _end(_file->end()), _first(0), _last(0), _row(), _done(false), _decoded(true) { load(); }
+  merge_run(T* first, T* last): _pos(0, 0), _end(0, 0), _first(first), _last(last), _row(), 
+    _done(first == last), _decoded(true) {}
+
+  bool done() const { return _done; }
+  bool good() const { return !_file || (_file->good() && _decoded); }
+  const T& current() const { return _file ? _row : *_first; }
+
+  // moves the current row to out and goes on
+  void take(T& out) {
+    out = std::move(_file ? _row : *_first);
+    next();
+  }
+  // the encoded record of the current row (file runs only)
+  std::pair<const char*, std::size_t> record() const { 
+    record_view<T> view = *_pos;
+    return std::make_pair(view.data(), view.size()); 
+  }
+  void next() {
+    if (_file) { ++_pos; load(); }
+    else _done = ++_first == _last;
+  }
+
+private:
+  void load() {
+    _done = _pos == _end;
+    if (!_done && !(*_pos).decode(_row.value())) _done = !(_decoded = false);
+  }
+
+  std::unique_ptr<file_type> _file;
+  typename file_type::iterator _pos, _end;
+  T* _first;
+  T* _last;
+  T _row;
+  bool _done, _decoded;
+};
+
+//////////////////////// sorted_distributor
+
+// distributes the row taken by >>, or nothing when there was none
+template<class T, class S = T> struct sorted_distributor : public sorted_distributor<T, typename S::tail_type> {
+  typedef sorted_distributor<T, typename S::tail_type> super;
+  sorted_distributor(T* row): super(row) {}
+
+  template<class V> super& operator| (V& v) { 
+    if (this->_row) v = TBD_TUPLE_TRANSFER(const typename S::head_type&, ((S&)*this->_row).head()); 
+    return *this; 
+  }
+  super& operator| (const ignore&) { return *this; }
+};
+
+template<class T> struct sorted_distributor<T, tuple_end> {
+  sorted_distributor(T* row): _row(row) {}
+protected:
+  T* _row;
+};
+
+//////////////////////// external_sorter
+
+struct external_sort_config {
+  external_sort_config(std::size_t memory = std::size_t(256) << 20): 
+    memory(memory), run_rows(0), fan_in(64), threads(0) {}
+
+  std::size_t memory;    // bytes of rows in memory (two runs: one filled while the other is written)
+  std::size_t run_rows;  // rows per run at most, 0 as many as fit into memory / 2
+  unsigned fan_in;       // runs merged at once, more runs are merged in passes before
+  unsigned threads;      // threads sorting a run, 0 all hardware threads
+  std::string directory; // of the run files, empty for $TMPDIR or /tmp
+};
+
+// Sorts more tuples than fit into memory. Tuples are added with push() or
+// <<, when a run is full it is sorted (parallel_sort) and written as records
+// to a temporary file on a background thread while the next run is filled.
+// sort() merges the runs in passes of fan_in runs until the rest can be 
+// merged while reading: next() or >> take the rows in order. The last run 
+// never leaves memory, if there is only one nothing is written at all. 
+// Less may compare a projected key (select_less<2, 0>). Like parallel_sort 
+// the order of equal rows is not kept. good() is false once a run file 
+// could not be created or written, the rows stay in memory then (or the 
+// runs unmerged) and none is lost. It is false as well if a run could not
+// be read back completely (the rows of a removed or truncated file are 
+// missing then) and after >> past the last row, which leaves the values 
+// untouched.
+template<class T, class Less = std::less<T> > struct external_sorter {
+  typedef external_sorter<T, Less> self;
+  typedef T tuple_type;
+  typedef typename tuple_type::value_type value_type;
+  typedef merge_run<T> run_type;
+
+  explicit external_sorter(const external_sort_config& config = external_sort_config(), Less less = Less()): 
+    _config(config), _less(less), _bytes(0), _counted(0), _rows(0), _written(0), _taken(0), 
+    _sorted(false), _good(true), _spill_good(true) {
+    if (_config.fan_in < 2) _config.fan_in = 2;
+    if (_config.directory.empty()) {
+      const char* tmp = std::getenv("TMPDIR");
+      _config.directory = tmp && *tmp ? tmp : "/tmp";
+    }
+    const std::size_t fit = _config.memory / 2 / sizeof(T);
+    _run_rows = _config.run_rows ? _config.run_rows : fit ? fit : 1;
+  }
+  ~external_sorter() {
+    wait();
+    _tree.reset();
+    _sources.clear();
+    for (std::size_t i = 0; i < _runs.size(); ++i) ::unlink(_runs[i].c_str());
+  }
+
+  external_sorter(const self&) = delete;
+  self& operator= (const self&) = delete;
+
+  void push(const tuple_type& t) { add(); _filling.back() = t; }
+  void push(tuple_type&& t) { add(); _filling.back() = std::move(t); }
+
+  template<class V> collector<value_type, typename value_type::tail_type> operator<< (V&& value) {
+    add();
+    return collector<value_type>(_filling.back().value()) | std::forward<V>(value);
+  }
+
+  // ends the input and prepares the merge, called by the first next() or >>
+  void sort() {
+    if (_sorted) return;
+    _sorted = true;
+    account();
+    wait();
+    parallel_sort(_filling.begin(), _filling.end(), _less, _config.threads);
+    while (_good && _runs.size() + 1 > _config.fan_in) merge_pass();
+    for (std::size_t i = 0; i < _runs.size(); ++i) {
+      _sources.push_back(run_type(_runs[i].c_str()));
+      if (!_sources.back().good()) _good = false;
+    }
+    _sources.push_back(run_type(_filling.data(), _filling.data() + _filling.size()));
+    _tree.reset(new loser_tree<run_type, Less>(_sources, _less));
+  }
+
+  // the next row in order, false after the last one
+  bool next(tuple_type& row) {
+    sort();
+    if (!more()) return false;
+    _sources[_tree->top()].take(row);
+    _tree->replay();
+    ++_taken;
+    return true;
+  }
+  explicit operator bool() { 
+    sort(); 
+    return more(); 
+  }
+  template<class V> sorted_distributor<value_type, typename value_type::tail_type> operator>> (V& value) {
+    value_type* row = &_row.value();
+    if (!next(_row)) {
+      _good = false;
+      row = 0;
+    }
+    return sorted_distributor<value_type>(row) | value;
+  }
+
+  // rows added
+  std::size_t size() const { return _rows; }
+  // runs written to files so far
+  std::size_t runs() const { return _written; }
+  bool good() const { return _good; }
+
+private:
+  // false at the end, which clears good() if rows went missing on the way
+  bool more() {
+    if (_tree->top() != _sources.size()) return true;
+    for (std::size_t i = 0; i < _sources.size(); ++i) _good = _good && _sources[i].good();
+    _good = _good && _taken == _rows;
+    return false;
+  }
+
+  // a new row at the end of the current run, which is spilled when it is full
+  void add() {
+    account();
+    if (_good && (_filling.size() >= _run_rows || _bytes >= _config.memory / 2)) spill();
+    if (_filling.capacity() == _filling.size()) _filling.reserve(std::min(_run_rows, std::max<std::size_t>(1024, 2 * _filling.size())));
+    _filling.push_back(tuple_type());
+    ++_rows;
+  }
+  // the bytes of the last row, counted once it is filled
+  void account() {
+    if (_filling.size() > _counted) {
+      _bytes += sizeof(T) + variable_size(_filling.back().value());
+      _counted = _filling.size();
+    }
+  }
+
+  void spill() {
+    wait();
+    std::string path;
+    int fd = _good ? create(path) : -1;
+    if (fd < 0) { _good = false; return; }
+    _spilling.swap(_filling);
+    _filling.clear();
+    _bytes = 0;
+    _counted = 0;
+    _runs.push_back(path);
+    _counts.push_back(_spilling.size());
+    _worker = std::thread([this, fd]() {
+      parallel_sort(_spilling.begin(), _spilling.end(), _less, _config.threads);
+      record_writer out(fd, 1 << 20);
+      for (std::size_t i = 0; i < _spilling.size(); ++i) out.write(_spilling[i]);
+      _spill_good = out.flush();
+      ::close(fd);
+      if (_spill_good) _spilling.clear();
+    });
+    ++_written;
+  }
+  // joins the spilling thread, the rows of a run that failed to be written go back to memory
+  void wait() { 
+    if (_worker.joinable()) _worker.join(); 
+    if (_spill_good) return;
+    _good = false;
+    _spill_good = true;
+    std::move(_spilling.begin(), _spilling.end(), std::back_inserter(_filling));
+    _spilling.clear();
+    ::unlink(_runs.back().c_str());
+    _runs.pop_back();
+    _counts.pop_back();
+    --_written;
+  }
+
+  // merges every fan_in runs into one, the records are copied as they are. 
+  // Runs that could not be read back completely are kept (and good() cleared).
+  void merge_pass() {
+    std::vector<std::string> merged;
+    std::vector<std::size_t> counts;
+    for (std::size_t first = 0; first < _runs.size(); first += _config.fan_in) {
+      std::size_t last = std::min(_runs.size(), first + _config.fan_in);
+      if (last - first == 1) { 
+        merged.push_back(_runs[first]); 
+        counts.push_back(_counts[first]);
+        continue; 
+      }
+      std::string path;
+      int fd = create(path);
+      if (fd >= 0) {
+        std::size_t rows = 0, expected = 0;
+        {
+          std::vector<run_type> sources;
+          for (std::size_t i = first; i < last; ++i) {
+            sources.push_back(run_type(_runs[i].c_str()));
+            expected += _counts[i];
+          }
+          loser_tree<run_type, Less> tree(sources, _less);
+          text_writer out(fd, 1 << 20);
+          for (std::size_t top; (top = tree.top()) != sources.size(); tree.replay(), ++rows) {
+            std::pair<const char*, std::size_t> r = sources[top].record();
+            out.append(r.first, r.second);
+            sources[top].next();
+          }
+          if (!out.flush() || rows != expected) _good = false;
+          for (std::size_t i = 0; i < sources.size(); ++i) _good = _good && sources[i].good();
+        }
+        ::close(fd);
+        if (_good) {
+          for (std::size_t i = first; i < last; ++i) ::unlink(_runs[i].c_str());
+          merged.push_back(path);
+          counts.push_back(expected);
+          ++_written;
+          continue;
+        }
+        ::unlink(path.c_str());
+      }
+      _good = false;
+      merged.insert(merged.end(), _runs.begin() + first, _runs.end());
+      counts.insert(counts.end(), _counts.begin() + first, _counts.end());
+      break;
+    }
+    _runs.swap(merged);
+    _counts.swap(counts);
+  }
+
+  // a new file for a run, -1 if it could not be created
+  int create(std::string& path) const {
+    path = _config.directory + "/tbd_sort_XXXXXX";
+    return ::mkstemp(&path[0]);
+  }
+
+  external_sort_config _config;
+  Less _less;
+  std::size_t _run_rows;
+  std::vector<tuple_type> _filling, _spilling;
+  std::size_t _bytes, _counted, _rows, _written, _taken;
+  std::thread _worker;
+  std::vector<std::string> _runs;
+  std::vector<std::size_t> _counts; // rows in every run
+  std::vector<run_type> _sources;
+  std::unique_ptr<loser_tree<run_type, Less> > _tree;
+  tuple_type _row;
+  bool _sorted, _good, _spill_good;
+};
+
+} // namespace tuple_details
+
+// lifting the merge types to tbd namespace
+using tuple_details::loser_tree;
+using tuple_details::external_sort_config;
+using tuple_details::external_sorter;
+
+} // namspace tbd
+
+#endif // __tuple_merge_h__
@@ -0,0 +1,166 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <algorithm>
+#include <cassert>
+#include <csignal>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "tuple_merge.h"
+#include "tuple_select.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::loser_tree;
+using tbd::external_sort_config;
+using tbd::external_sorter;
+using tbd::select_less;
+
+typedef tuple<int, string, double> row;
+
+// a sorted vector as a loser_tree source
+struct vector_source {
+  vector_source(const vector<int>& v): _v(&v), _pos(0) {}
+  bool done() const { return _pos == _v->size(); }
+  const int& current() const { return (*_v)[_pos]; }
+  const vector<int>* _v;
+  size_t _pos;
+};
+
+vector<row> rows(int n) {
+  vector<row> result;
+  srand(7);
+  for (int i = 0; i < n; ++i) result.push_back(row(accu << rand() % 500 | string(rand() % 12, 'a' + i % 26) | i * 0.25));
+  return result;
+}
+
+template<class Less> vector<row> sorted(const vector<row>& input, const external_sort_config& config, 
+  size_t& runs, Less less = Less(), bool good = true) {
+  external_sorter<row, Less> sorter(config, less);
+  for (size_t i = 0; i < input.size(); ++i) {
+    if (i % 2) sorter.push(input[i]);
+    else sorter << input[i].get<0>() | input[i].get<1>() | input[i].get<2>();
+  }
+  assert(sorter.size() == input.size());
+  vector<row> output;
+  for (row r; sorter.next(r); ) output.push_back(r);
+  assert(sorter.good() == good && !sorter);
+  runs = sorter.runs();
+  return output;
+}
+
+int main() {
+  // k sorted sequences merged by the loser tree, ties go to the lower source
+  vector<vector<int> > lists(6); // the last one stays empty
+  for (int i = 0; i < 100; ++i) lists[i * 7 % 5].push_back(i / 3);
+  vector<vector_source> sources(lists.begin(), lists.end());
+  loser_tree<vector_source, std::less<int> > tree(sources, std::less<int>());
+  vector<int> merged;
+  for (size_t top; (top = tree.top()) != sources.size(); tree.replay()) {
+    merged.push_back(sources[top].current());
+    ++sources[top]._pos;
+  }
+  assert(merged.size() == 100 && std::is_sorted(merged.begin(), merged.end()));
+
+  vector<row> input = rows(20000);
+  vector<row> expected(input);
+  std::sort(expected.begin(), expected.end());
+
+  // small runs and fan in: spilled runs are merged in several passes
+  external_sort_config config;
+  config.run_rows = 700;
+  config.fan_in = 3;
+  config.threads = 2;
+  size_t runs = 0;
+  assert(sorted<std::less<row> >(input, config, runs) == expected);
+  assert(runs > 28);
+
+  // a memory budget instead of a row count 
+  external_sort_config small(64 << 10);
+  assert(sorted<std::less<row> >(input, small, runs) == expected);
+  assert(runs > 1);
+
+  // everything fits: nothing is written
+  assert(sorted<std::less<row> >(input, external_sort_config(), runs) == expected);
+  assert(runs == 0);
+
+  // by a projected key
+  typedef select_less<2, 0> by_key;
+  vector<row> by(input);
+  std::sort(by.begin(), by.end(), by_key());
+  assert(sorted<by_key>(input, config, runs) == by);
+
+  // rows come out with >> as well
+  external_sorter<row> sorter(config);
+  for (int i = 5000; i > 0; --i) sorter << i | "x" | 0.5;
+  int n = 0, previous = 0, i = 0;
+  string s;
+  double d = 0;
+  while (sorter) {
+    sorter >> i | s | d;
+    assert(i == previous + 1 && s == "x" && d == 0.5);
+    previous = i;
+    ++n;
+  }
+  assert(n == 5000 && sorter.runs() > 0);
+  assert(sorter.good());
+
+  // >> past the last row fails and leaves the values as they are
+  sorter >> i | s | d;
+  assert(!sorter.good() && i == 5000 && s == "x");
+
+  // rows whose runs cannot be created or written stay in memory
+  external_sort_config missing(config);
+  missing.directory = "/nonexistent/directory";
+  assert(sorted<std::less<row> >(input, missing, runs, std::less<row>(), false) == expected);
+  assert(runs == 0);
+
+  signal(SIGXFSZ, SIG_IGN);
+  rlimit limit, unlimited;
+  getrlimit(RLIMIT_FSIZE, &unlimited);
+  limit = unlimited;
+  const rlim_t sizes[2] = { 8 << 10, 64 << 10 }; // the runs fail, the merged runs fail
+  for (int k = 0; k < 2; ++k) {
+    limit.rlim_cur = sizes[k];
+    setrlimit(RLIMIT_FSIZE, &limit);
+    assert(sorted<std::less<row> >(input, config, runs, std::less<row>(), false) == expected);
+  }
+  setrlimit(RLIMIT_FSIZE, &unlimited);
+
+  // run files that are gone lose their rows, which good() tells
+  char directory[] = "/tmp/tuple_merge_test_XXXXXX";
+  assert(mkdtemp(directory));
+  external_sort_config damaged(config);
+  damaged.directory = directory;
+  {
+    external_sorter<row> lossy(damaged);
+    for (size_t i = 0; i < input.size(); ++i) lossy.push(input[i]);
+    DIR* files = opendir(directory);
+    int removed = 0;
+    while (dirent* file = readdir(files)) {
+      if (file->d_name[0] != '.' && removed++ % 4 == 0) unlink((string(directory) + "/" + file->d_name).c_str());
+    }
+    closedir(files);
+    size_t left = 0;
+    for (row r; lossy.next(r); ) ++left;
+    assert(left < input.size() && !lossy.good());
+  }
+  rmdir(directory);
+
+  // nothing to sort
+  external_sorter<row> empty;
+  row r;
+  assert(!empty && !empty.next(r) && empty.good());
+
+  cout << "merged " << input.size() << " rows from " << runs << " runs" << endl;
+  return 0;
+}
@@ -0,0 +1,348 @@
+// Benchmarks of the basic tuple operations against std::tuple and a plain
+// struct, for 1 to 10 elements of numbers or strings and ints.
+// build: g++ -O2 -std=c++17 tuple_ops_bench.cc -o tuple_ops_bench
+// usage: tuple_ops_bench [filter] [rows]
+// Prints one CSV line per case (only those containing filter, e.g. "join" or
+// "compare,10,"), so the output of two versions can be diffed directly:
+// operation,elements,types,impl,ns_per_op,allocs_per_op
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+
+#include "tuple.h"
+using tbd::accu;
+using tbd::tuple_details::type_list;
+using tbd::tuple_details::list_append;
+using tbd::tuple_details::index_sequence;
+using tbd::tuple_details::make_indices;
+
+//////////////////////// measuring
+
+// counts heap allocations
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+std::atomic<std::size_t> allocations(0);
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// keeps the optimizer from dropping unused results
+template<class T> void keep(T value) {
+  static volatile T sink;
+  sink = value;
+  (void)sink;
+}
+
+const char* filter = "";
+std::size_t rows = 100000;
+
+// runs f(i) for every row, repeated until 50 ms have passed, and prints the case
+template<class F> void run(const char* operation, int elements, const char* types, const char* impl, F f) {
+  std::ostringstream name;
+  name << operation << "," << elements << "," << types << "," << impl;
+  if (name.str().find(filter) == string::npos) return;
+
+  std::size_t ops = 0, before = allocations;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double ms = 0;
+  do {
+    for (std::size_t i = 0; i < rows; ++i) f(i);
+    ops += rows;
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  } while (ms < 50);
+  cout << name.str() << "," << ms * 1e6 / ops << "," << double(allocations - before) / ops << endl;
+}
+
+//////////////////////// element types and values
+
+// numbers: int, double, long long, int, ...  strings: string, int, string, ...
+struct numbers { static const char* name() { return "numbers"; } };
+struct strings { static const char* name() { return "strings"; } };
+
+template<class Kind, int I> struct element_type;
+template<int I> struct element_type<numbers, I> {
+  typedef typename std::conditional<I % 3 == 0, int, typename std::conditional<I % 3 == 1, double, long long>::type>::type type;
+};
+template<int I> struct element_type<strings, I> {
+  typedef typename std::conditional<I % 2 == 0, string, int>::type type;
+};
+
+template<class Kind, int N> struct element_types {
+  typedef typename list_append<typename element_types<Kind, N - 1>::type, typename element_type<Kind, N - 1>::type>::type type;
+};
+template<class Kind> struct element_types<Kind, 0> { typedef type_list<> type; };
+
+// the value of element e in row i, strings are too long for the small string buffer
+template<class T> T make_value(std::size_t i, int e) { return T((i * 7 + e) % 1000); }
+template<> string make_value<string>(std::size_t i, int e) {
+  return "value number " + std::to_string((i * 7 + e) % 1000) + " of the row";
+}
+
+// what an element adds to a checksum
+inline double weight(int v) { return v; }
+inline double weight(long long v) { return double(v); }
+inline double weight(double v) { return v; }
+inline double weight(const string& v) { return double(v.size()); }
+
+// the runtime conversion all three implementations use
+template<class To, class From> To to_value(const From& v, std::true_type) { return v; }
+template<class To, class From> To to_value(const From& v, std::false_type) { return tbd::tuple_details::convert_value<To>(v); }
+template<class To, class From> To to_value(const From& v) { return to_value<To>(v, std::is_same<To, From>()); }
+
+// evaluates the arguments in order
+struct in_order { template<class... A> in_order(A&&...) {} };
+
+//////////////////////// plain struct
+
+// a hand written struct with up to 10 members, unused members are empty
+struct none {
+  none() {}
+  template<class V> none(const V&) {}
+  bool operator< (const none&) const { return false; }
+  bool operator== (const none&) const { return true; }
+};
+
+template<class T0, class T1 = none, class T2 = none, class T3 = none, class T4 = none,
+         class T5 = none, class T6 = none, class T7 = none, class T8 = none, class T9 = none>
+struct plain {
+  T0 a0; T1 a1; T2 a2; T3 a3; T4 a4; T5 a5; T6 a6; T7 a7; T8 a8; T9 a9;
+
+  bool operator< (const plain& o) const {
+    return std::tie(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9) < std::tie(o.a0, o.a1, o.a2, o.a3, o.a4, o.a5, o.a6, o.a7, o.a8, o.a9);
+  }
+  template<class V> V get(int i) const {
+    switch (i) {
+      case 0: return member(a0, V());
+      case 1: return member(a1, V());
+      case 2: return member(a2, V());
+      case 3: return member(a3, V());
+      case 4: return member(a4, V());
+      case 5: return member(a5, V());
+      case 6: return member(a6, V());
+      case 7: return member(a7, V());
+      case 8: return member(a8, V());
+      case 9: return member(a9, V());
+    }
+    return V();
+  }
+private:
+  template<class V, class M> static V member(const M& m, const V&) { return to_value<V>(m); }
+  template<class V> static V member(const none&, const V&) { return V(); }
+};
+
+#define TBD_PLAIN_MEMBER(I) \
+  template<class P> auto member(P& p, std::integral_constant<int, I>) -> decltype((p.a##I)) { return p.a##I; }
+TBD_PLAIN_MEMBER(0) TBD_PLAIN_MEMBER(1) TBD_PLAIN_MEMBER(2) TBD_PLAIN_MEMBER(3) TBD_PLAIN_MEMBER(4)
+TBD_PLAIN_MEMBER(5) TBD_PLAIN_MEMBER(6) TBD_PLAIN_MEMBER(7) TBD_PLAIN_MEMBER(8) TBD_PLAIN_MEMBER(9)
+#undef TBD_PLAIN_MEMBER
+
+//////////////////////// the three implementations
+
+// every implementation provides make, spread (into a std::tuple of variables),
+// sum (of all elements with compile time access), at (runtime access),
+// less, join and walk (runtime access to every element)
+
+template<class L> struct tbd_impl;
+template<class... T> struct tbd_impl<type_list<T...> > {
+  typedef tbd::tuple<T...> type;
+  static const char* name() { return "tbd::tuple"; }
+
+  template<class B> static type build(const B& b) { return b; }
+  template<class B, class V, class... R> static type build(const B& b, const V& v, const R&... rest) { return build(b | v, rest...); }
+  template<class V, class... R> static type make(const V& v, const R&... rest) { return build(accu << v, rest...); }
+
+  template<class D> static void distribute(D&&) {}
+  template<class D, class V, class... R> static void distribute(D&& d, V& v, R&... rest) { distribute(d | v, rest...); }
+  template<class V, class... R> static void spread(type& t, V& v, R&... rest) { distribute(t >> v, rest...); }
+
+  template<std::size_t... I> static double sum(const type& t, index_sequence<I...>) {
+    const double weights[] = { weight(t.template get<I>())... };
+    double s = 0;
+    for (std::size_t i = 0; i < sizeof...(I); ++i) s += weights[i];
+    return s;
+  }
+  template<class V> static V at(type& t, int i) { return t.template get<V>(i); }
+  static bool less(const type& l, const type& r) { return l < r; }
+  static void join(const type& t, string& out) { t.join_to(out, ","); }
+  template<class V> static double walk(type& t) {
+    typedef tbd::tuple_details::element_iterator<typename type::value_type, V> iterator;
+    double s = 0;
+    for (iterator i = t.template begin<V>(), end = t.template end<V>(); i != end; ++i) s += weight(*i);
+    return s;
+  }
+};
+
+template<class L> struct std_impl;
+template<class... T> struct std_impl<type_list<T...> > {
+  typedef std::tuple<T...> type;
+  static const char* name() { return "std::tuple"; }
+
+  template<class... V> static type make(const V&... v) { return std::make_tuple(v...); }
+  template<class... V> static void spread(type& t, V&... v) { std::tie(v...) = t; }
+
+  template<std::size_t... I> static double sum(const type& t, index_sequence<I...>) {
+    const double weights[] = { weight(std::get<I>(t))... };
+    double s = 0;
+    for (std::size_t i = 0; i < sizeof...(I); ++i) s += weights[i];
+    return s;
+  }
+  template<class V> static V at_index(type&, int, std::integral_constant<std::size_t, sizeof...(T)>) { return V(); }
+  template<class V, std::size_t I> static V at_index(type& t, int i, std::integral_constant<std::size_t, I>) {
+    return i == (int)I ? to_value<V>(std::get<I>(t)) : at_index<V>(t, i, std::integral_constant<std::size_t, I + 1>());
+  }
+  template<class V> static V at(type& t, int i) { return at_index<V>(t, i, std::integral_constant<std::size_t, 0>()); }
+  static bool less(const type& l, const type& r) { return l < r; }
+
+  static void append(string& out, const string& v) { out += v; }
+  template<class V> static void append(string& out, V v) { out += std::to_string(v); }
+  template<std::size_t... I> static void join(const type& t, string& out, index_sequence<I...>) {
+    in_order{ (I ? out += ',' : out, append(out, std::get<I>(t)), 0)... };
+  }
+  static void join(const type& t, string& out) { join(t, out, typename make_indices<sizeof...(T)>::type()); }
+  template<class V> static double walk(type& t) {
+    double s = 0;
+    for (int i = 0; i < (int)sizeof...(T); ++i) s += weight(at<V>(t, i));
+    return s;
+  }
+};
+
+template<class L> struct plain_impl;
+template<class... T> struct plain_impl<type_list<T...> > {
+  typedef plain<T...> type;
+  static const char* name() { return "struct"; }
+
+  template<class... V> static type make(const V&... v) { 
+    type p = type();
+    fill(p, typename make_indices<sizeof...(V)>::type(), v...);
+    return p; 
+  }
+  template<std::size_t... I, class... V> static void fill(type& p, index_sequence<I...>, const V&... v) {
+    in_order{ (member(p, std::integral_constant<int, I>()) = v, 0)... };
+  }
+  template<class... V> static void spread(type& p, V&... v) { spread(p, typename make_indices<sizeof...(T)>::type(), v...); }
+  template<std::size_t... I, class... V> static void spread(type& p, index_sequence<I...>, V&... v) {
+    in_order{ (v = member(p, std::integral_constant<int, I>()))... };
+  }
+
+  template<std::size_t... I> static double sum(const type& p, index_sequence<I...>) {
+    const double weights[] = { weight(member(p, std::integral_constant<int, I>()))... };
+    double s = 0;
+    for (std::size_t i = 0; i < sizeof...(I); ++i) s += weights[i];
+    return s;
+  }
+  template<class V> static V at(type& p, int i) { return p.template get<V>(i); }
+  static bool less(const type& l, const type& r) { return l < r; }
+
+  template<std::size_t... I> static void join(const type& p, string& out, index_sequence<I...>) {
+    in_order{ (I ? out += ',' : out, std_impl<type_list<T...> >::append(out, member(p, std::integral_constant<int, I>())), 0)... };
+  }
+  static void join(const type& p, string& out) { join(p, out, typename make_indices<sizeof...(T)>::type()); }
+  template<class V> static double walk(type& p) {
+    double s = 0;
+    for (int i = 0; i < (int)sizeof...(T); ++i) s += weight(p.template get<V>(i));
+    return s;
+  }
+};
+
+//////////////////////// cases
+
+template<class L> struct values;
+template<class... T> struct values<type_list<T...> > {
+  typedef std::tuple<T...> type;
+  template<std::size_t... I> static type make(std::size_t i, index_sequence<I...>) { return type(make_value<T>(i, I)...); }
+  static type make(std::size_t i) { return make(i, typename make_indices<sizeof...(T)>::type()); }
+};
+
+template<class Impl, class L, class Source, std::size_t... I>
+typename Impl::type make_row(const Source& s, index_sequence<I...>) { return Impl::make(std::get<I>(s)...); }
+
+template<class Impl, class Target, std::size_t... I>
+void spread_row(typename Impl::type& t, Target& out, index_sequence<I...>) { Impl::spread(t, std::get<I>(out)...); }
+
+// all operations of one implementation for one element list
+template<class Impl, class Kind, class L> void run_impl(const vector<typename values<L>::type>& source) {
+  typedef typename Impl::type row;
+  typedef typename make_indices<L::size>::type indices;
+  typedef typename std::conditional<std::is_same<Kind, strings>::value, string, double>::type runtime_type;
+  const int n = L::size;
+  const char* kind = Kind::name();
+  const char* impl = Impl::name();
+
+  vector<row> table;
+  for (std::size_t i = 0; i < source.size(); ++i) table.push_back(make_row<Impl, L>(source[i], indices()));
+  double checksum = 0;
+
+  run("construct", n, kind, impl, [&](std::size_t i) {
+    row r = make_row<Impl, L>(source[i], indices());
+    checksum += Impl::sum(r, indices());
+  });
+  typename values<L>::type out;
+  run("distribute", n, kind, impl, [&](std::size_t i) {
+    spread_row<Impl>(table[i], out, indices());
+    checksum += weight(std::get<0>(out));
+  });
+  run("get<C>", n, kind, impl, [&](std::size_t i) { checksum += Impl::sum(table[i], indices()); });
+  run("get<T>(i)", n, kind, impl, [&](std::size_t i) {
+    checksum += weight(Impl::template at<runtime_type>(table[i], int(i % n)));
+  });
+  run("compare", n, kind, impl, [&](std::size_t i) {
+    checksum += Impl::less(table[i], table[(i + 1) % table.size()]);
+  });
+  string text;
+  run("join", n, kind, impl, [&](std::size_t i) {
+    text.clear();
+    Impl::join(table[i], text);
+    checksum += text.size();
+  });
+  run("iterate", n, kind, impl, [&](std::size_t i) { checksum += Impl::template walk<runtime_type>(table[i]); });
+  keep(checksum);
+}
+
+template<class Kind, int N> void run_size() {
+  typedef typename element_types<Kind, N>::type list;
+  vector<typename values<list>::type> source;
+  for (std::size_t i = 0; i < rows; ++i) source.push_back(values<list>::make(i));
+  run_impl<tbd_impl<list>, Kind, list>(source);
+  run_impl<std_impl<list>, Kind, list>(source);
+  run_impl<plain_impl<list>, Kind, list>(source);
+}
+
+template<class Kind, int N> struct run_sizes {
+  static void run() {
+    run_sizes<Kind, N - 1>::run();
+    run_size<Kind, N>();
+  }
+};
+template<class Kind> struct run_sizes<Kind, 0> { static void run() {} };
+
+int main(int argc, char** argv) {
+  if (argc > 1) filter = argv[1];
+  if (argc > 2) rows = std::strtoul(argv[2], 0, 10);
+
+  cout << "operation,elements,types,impl,ns_per_op,allocs_per_op" << endl;
+  run_sizes<numbers, 10>::run();
+  run_sizes<strings, 10>::run();
+  return 0;
+}
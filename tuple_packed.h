@@ -0,0 +1,284 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+#ifndef __tuple_packed_h__
+#define __tuple_packed_h__
+
+#include <utility>
+#include <type_traits>
+#include "tuple.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// layout
+
+// tuple_item stores its tail first, so the last element of the chain comes 
+// first in memory. Sorting the chain by ascending alignment (keeping the 
+// order of elements with the same alignment) puts the biggest alignment 
+// first in memory and leaves padding only at the end.
+
+template<class T, int C> struct packed_align {
+  enum { value = std::alignment_of<typename tuple_element<C, T>::type::head_type>::value };
+};
+
+// position of the logical element C in the chain
+template<class T, int C, int J = T::size - 1> struct packed_position {
+  enum { value = (int)packed_position<T, C, J - 1>::value + 
+    ((int)packed_align<T, J>::value < (int)packed_align<T, C>::value || 
+     ((int)packed_align<T, J>::value == (int)packed_align<T, C>::value && J < C)) };
+};
+template<class T, int C> struct packed_position<T, C, -1> { enum { value = 0 }; };
+
+// logical element stored at position P
+template<class T, int P, int C = 0, bool = ((int)packed_position<T, C>::value == P)> struct packed_source {
+  enum { value = packed_source<T, P, C + 1>::value };
+};
+template<class T, int P, int C> struct packed_source<T, P, C, true> { enum { value = C }; };
+
+template<class T, int P = 0, bool = (P == (int)T::size)> struct packed_items {
+  typedef typename tuple_element<packed_source<T, P>::value, T>::type::head_type head_type;
+  typedef tuple_item<head_type, typename packed_items<T, P + 1>::type> type;
+};
+template<class T, int P> struct packed_items<T, P, true> { typedef tuple_end type; };
+
+// position of a logical index known at runtime only
+template<class T, int C = 0, bool = (C == (int)T::size)> struct packed_index {
+  static int get(int i) { return i == C ? (int)packed_position<T, C>::value : packed_index<T, C + 1>::get(i); }
+};
+template<class T, int C> struct packed_index<T, C, true> { 
+  static int get(int i) { return i; } 
+};
+
+//////////////////////// view
+
+// Presents the elements of a packed tuple in logical order with the 
+// head() / tail() interface of tuple_item, so compare, eq and hash work
+// on packed tuples (and between packed and plain tuples).
+
+template<class P, class S> struct packed_view;
+
+template<class P, class S> struct packed_view_of { 
+  typedef packed_view<P, S> type;
+  static type make(P& p) { return type(p); }
+};
+template<class P> struct packed_view_of<P, tuple_end> { 
+  typedef tuple_end type;
+  static type make(P&) { return tuple_end(); }
+};
+
+template<class P, class S> struct packed_view {
+  enum { size = S::size, index = (int)P::size - (int)S::size };
+  typedef typename std::conditional<std::is_const<P>::value, 
+    const typename S::head_type, typename S::head_type>::type head_type;
+  typedef typename packed_view_of<P, typename S::tail_type>::type tail_type;
+
+  explicit packed_view(P& p): _packed(p) {}
+
+  head_type& head() const { return _packed.template get<index>(); }
+  tail_type tail() const { return packed_view_of<P, typename S::tail_type>::make(_packed); }
+private:
+  P& _packed;
+};
+
+//////////////////////// collector / distributor / accept
+
+template<class P, class S = typename P::value_type> 
+struct packed_collector : public packed_collector<P, typename S::tail_type> {
+  typedef packed_collector<P, typename S::tail_type> super;
+  packed_collector(P& p): super(p) {}
+
+  template<class V> super& operator| (V&& v) { 
+    this->_packed.template get<(int)P::size - (int)S::size>() = std::forward<V>(v); 
+    return *this; 
+  }
+  super& operator| (const ignore&) { return *this; }
+};
+
+template<class P> struct packed_collector<P, tuple_end> {
+  packed_collector(P& p): _packed(p) {}
+  operator P& () { return _packed; }
+protected:
+  P& _packed;
+};
+
+template<class P, class S = typename P::value_type> 
+struct packed_distributor : public packed_distributor<P, typename S::tail_type> {
+  typedef packed_distributor<P, typename S::tail_type> super;
+  packed_distributor(P& p): super(p) {}
+
+  template<class V> super& operator| (V& v) { 
+    const typename S::head_type& element = this->_packed.template get<(int)P::size - (int)S::size>();
+    v = TBD_TUPLE_TRANSFER(const typename S::head_type&, element); 
+    return *this; 
+  }
+  super& operator| (const ignore&) { return *this; }
+};
+
+template<class P> struct packed_distributor<P, tuple_end> {
+  packed_distributor(P& p): _packed(p) {}
+  operator P& () { return _packed; }
+protected:
+  P& _packed;
+};
+
+template<class P, class V> void packed_accept(P&, V&, const tuple_end*) {}
+template<class P, class V, class S> void packed_accept(P& p, V& visitor, const S*) {
+  visitor(p.template get<(int)P::size - (int)S::size>(), (int)P::size - (int)S::size);
+  packed_accept(p, visitor, (const typename S::tail_type*)0);
+}
+
+template<class P> void packed_assign(P&, const tuple_end&) {}
+template<class P, class T> void packed_assign(P& p, const T& t) {
+  p.template get<(int)P::size - (int)T::size>() = t.head();
+  packed_assign(p, t.tail());
+}
+
+template<class P> void packed_move(P&, tuple_end&) {}
+template<class P, class T> void packed_move(P& p, T& t) {
+  p.template get<(int)P::size - (int)T::size>() = std::move(t.head());
+  packed_move(p, t.tail());
+}
+
+//////////////////////// packed_tuple
+
+// Holds the same elements as tuple<S0, S1, ...> in an order that needs as 
+// little padding as possible. All indices are the logical ones, only the 
+// memory layout differs: sizeof(packed_tuple<char, double, char, double>) 
+// is 24 instead of 32.
+
+template<class... S> 
+struct packed_tuple {
+  typedef packed_tuple<S...> self;
+  typedef tuple<S...> tuple_type;
+  typedef typename tuple_type::value_type value_type;
+  typedef typename packed_items<value_type>::type storage_type;
+  enum { size = value_type::size };
+
+  template<int C> struct element { 
+    typedef typename tuple_element<C, value_type>::type::head_type type; 
+  };
+  template<int C> struct position { 
+    enum { value = packed_position<value_type, C>::value }; 
+  };
+
+  packed_tuple() = default;
+  template<class HT, class TT> packed_tuple(const tuple_item<HT, TT>& t) { packed_assign(*this, t); }
+  template<class HT, class TT> packed_tuple(tuple_item<HT, TT>&& t) { packed_move(*this, t); }
+  template<class P, class V> packed_tuple(const tuple_builder<P, V>& b) { 
+    static_assert((int)tuple_builder<P, V>::size == (int)value_type::size, "accu << ... needs one value per element");
+    value_type t(b);
+    packed_move(*this, t); 
+  }
+
+  template<int C> typename element<C>::type& get() { 
+    return tuple_get<position<C>::value>(_items); 
+  }
+  template<int C> const typename element<C>::type& get() const { 
+    return tuple_get<position<C>::value>(_items); 
+  }
+  template<class T> T get(int i) {
+    return converter<storage_type, T>::get(_items, packed_index<value_type>::get(i));
+  }
+  template<int C> void set(const typename element<C>::type& v) { 
+    get<C>() = v; 
+  }
+
+  template<int C> struct accessor : tuple_accessor<position<C>::value, storage_type> { 
+    typedef typename element<C>::type V;
+    accessor(self& t): tuple_accessor<position<C>::value, storage_type>(t._items) {}
+    accessor<C>& operator= (const V& value) { 
+      ((tuple_accessor<position<C>::value, storage_type>&)*this) = value; 
+      return *this;
+    }
+  };
+
+  template<class V> 
+  packed_collector<self, typename value_type::tail_type> operator<< (V&& value) {
+    return packed_collector<self>(*this) | std::forward<V>(value);
+  }
+
+  template<class V> 
+  packed_distributor<self, typename value_type::tail_type> operator>> (V& value) {
+    return packed_distributor<self>(*this) | value;
+  }
+
+  template<class V> V& accept(V& visitor) { 
+    packed_accept(*this, visitor, (const value_type*)0);
+    return visitor; 
+  }
+  template<class V> const V& accept(const V& visitor) { 
+    packed_accept(*this, visitor, (const value_type*)0);
+    return visitor; 
+  }
+  template<class V> V& accept(V& visitor) const { 
+    packed_accept(*this, visitor, (const value_type*)0);
+    return visitor; 
+  }
+  template<class V> const V& accept(const V& visitor) const { 
+    packed_accept(*this, visitor, (const value_type*)0);
+    return visitor; 
+  }
+
+  // the elements in logical order, for compare, eq, hash ...
+  packed_view<const self, value_type> view() const { return packed_view<const self, value_type>(*this); }
+  // copies the elements into a plain tuple
+  tuple_type unpack() const { 
+    tuple_type t;
+    tuple_copy_from(t, view());
+    return t; 
+  }
+
+  template<class... T> 
+  bool operator==(const packed_tuple<T...>& r) const { return eq(view(), r.view()); }
+  template<class... T> 
+  bool operator!=(const packed_tuple<T...>& r) const { return neq(view(), r.view()); }
+  template<class... T> 
+  bool operator< (const packed_tuple<T...>& r) const { return lt(view(), r.view()); }
+  template<class... T> 
+  bool operator> (const packed_tuple<T...>& r) const { return gt(view(), r.view()); }
+  template<class... T> 
+  bool operator<=(const packed_tuple<T...>& r) const { return lte(view(), r.view()); }
+  template<class... T> 
+  bool operator>=(const packed_tuple<T...>& r) const { return gte(view(), r.view()); }
+
+  storage_type& storage() { return _items; }
+  const storage_type& storage() const { return _items; }
+private:
+  template<class T> static void tuple_copy_from(T&, const tuple_end&) {}
+  template<class T, class V> static void tuple_copy_from(T& t, const V& v) {
+    tuple_set<V::index>(t.value(), v.head());
+    tuple_copy_from(t, v.tail());
+  }
+
+  storage_type _items;
+};
+
+} // namespace tuple_details
+
+using tuple_details::packed_tuple; // lifting packed_tuple to tbd namespace
+
+} // namspace tbd
+
+#endif // __tuple_packed_h__
@@ -0,0 +1,86 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+#include <type_traits>
+
+#include "tuple_packed.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::packed_tuple;
+
+struct summer {
+  double& sum;
+  int& count;
+  template<class V> void operator() (V& value, int i) { sum += value * (i + 1); ++count; }
+};
+
+// the padding is gone, the element order stays
+static_assert(sizeof(tuple<char, double, char, double>) == 32, "");
+static_assert(sizeof(packed_tuple<char, double, char, double>) == 24, "");
+static_assert(sizeof(packed_tuple<char, int, char, short, double>) == 16, "");
+static_assert(sizeof(packed_tuple<char, string, bool>) == sizeof(string) + sizeof(void*), "");
+static_assert(sizeof(packed_tuple<double, int>) == sizeof(tuple<double, int>), "");
+static_assert(std::is_same<packed_tuple<char, double>::element<1>::type, double>::value, "");
+static_assert(tbd::is_pod_tuple<packed_tuple<char, double, char, double> >::value, "");
+static_assert(std::is_trivially_default_constructible<packed_tuple<char, double, int> >::value, "");
+
+int main() {
+  typedef packed_tuple<char, double, char, double> row;
+  row r(accu << 'a' | 1.5 | 'b' | 2.5);
+
+  // one value per element, anything else does not compile:
+  // g++ -DTUPLE_TEST_TOO_MANY_VALUES or -DTUPLE_TEST_TOO_FEW_VALUES fails with
+  // "accu << ... needs one value per element"
+#ifdef TUPLE_TEST_TOO_MANY_VALUES
+  packed_tuple<int, double> too_many(accu << 1 | 2.0 | 3);
+#endif
+#ifdef TUPLE_TEST_TOO_FEW_VALUES
+  packed_tuple<int, double, int> too_few(accu << 1 | 2.0);
+#endif
+  assert(r.get<0>() == 'a' && r.get<1>() == 1.5 && r.get<2>() == 'b' && r.get<3>() == 2.5);
+
+  r.set<2>('c');
+  row::accessor<3> fourth(r);
+  fourth = 3.5;
+  assert(r.get<2>() == 'c' && r.get<3>() == 3.5);
+  assert(r.get<int>(2) == 'c' && r.get<double>(1) == 1.5 && r.get<string>(3) == "3.5");
+
+  r << 'x' | 4.5 | tbd::na | 5.5;
+  char c0, c2;
+  double d1, d3;
+  r >> c0 | d1 | c2 | d3;
+  assert(c0 == 'x' && d1 == 4.5 && c2 == 'c' && d3 == 5.5);
+
+  // into wider types the values are converted
+  packed_tuple<int, char, int> narrow(accu << -1 | 'n' | 2);
+  long long wide;
+  int two;
+  narrow >> wide | tbd::na | two;
+  const packed_tuple<int, char, int>& constant = narrow;
+  assert(wide == -1 && two == 2 && constant.get<0>() == -1);
+
+  // accept visits in logical order
+  double sum = 0;
+  int count = 0;
+  summer s = { sum, count };
+  r.accept(s);
+  assert(count == 4 && sum == 'x' + 4.5 * 2 + 'c' * 3 + 5.5 * 4);
+
+  // comparison is lexicographic in logical order, also against plain tuples
+  row a(accu << 'a' | 2.0 | 'a' | 1.0), b(accu << 'a' | 1.0 | 'b' | 9.0);
+  assert(b < a && a > b && a != b && a == row(a) && b <= a && a >= a);
+  assert(tbd::compare(a.view(), tuple<char, double, char, double>(accu << 'a' | 2.0 | 'a' | 1.0)) == 0);
+  assert(tbd::compare(a.view(), a.unpack()) == 0 && a.unpack().get<1>() == 2.0);
+  assert(tbd::hash(a.view()) == tbd::hash(a.unpack()));
+
+  packed_tuple<char, string, double> p(tuple<char, string, double>(accu << 'z' | "zed" | 0.5));
+  assert(p.get<1>() == "zed" && p.unpack().get<0>() == 'z');
+
+  cout << "packed " << sizeof(row) << " instead of " << sizeof(tuple<char, double, char, double>) << " bytes" << endl;
+  return 0;
+}
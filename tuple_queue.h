@@ -0,0 +1,284 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+#ifndef __tuple_queue_h__
+#define __tuple_queue_h__
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tuple.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// queue slots
+
+// Bounded lock-free queues of tuples. The tuples live in the ring and are
+// written and read in place: push() claims a slot, << fills it and the 
+// slot is published when the handle is destroyed, at the end of the 
+// statement:
+//
+//   queue.push() << id | price | amount;
+//   queue.pop() >> id | price | amount;
+//
+// try_push() / try_pop() return an empty handle (false) instead of waiting,
+// try_push(n) / try_pop(n) claim up to n slots at once and publish them 
+// together.
+
+template<class Q> struct push_slot {
+  typedef typename Q::value_type T;
+
+  push_slot(Q* q, std::size_t pos): _queue(q), _pos(pos) {}
+  push_slot(push_slot&& other): _queue(other._queue), _pos(other._pos) { other._queue = 0; }
+  ~push_slot() { if (_queue) _queue->publish(_pos, 1); }
+
+  explicit operator bool() const { return _queue != 0; }
+  T& operator*() const { return _queue->at(_pos); }
+  T* operator->() const { return &_queue->at(_pos); }
+
+  template<class V> auto operator<< (V&& v) const -> decltype(std::declval<T&>() << std::forward<V>(v)) { 
+    return _queue->at(_pos) << std::forward<V>(v); 
+  }
+private:
+  push_slot(const push_slot&);
+  push_slot& operator= (const push_slot&);
+
+  Q* _queue;
+  std::size_t _pos;
+};
+
+template<class Q> struct pop_slot {
+  typedef typename Q::value_type T;
+
+  pop_slot(Q* q, std::size_t pos): _queue(q), _pos(pos) {}
+  pop_slot(pop_slot&& other): _queue(other._queue), _pos(other._pos) { other._queue = 0; }
+  ~pop_slot() { if (_queue) _queue->release(_pos, 1); }
+
+  explicit operator bool() const { return _queue != 0; }
+  T& operator*() const { return _queue->at(_pos); }
+  T* operator->() const { return &_queue->at(_pos); }
+
+  template<class V> auto operator>> (V& v) const -> decltype(std::declval<T&>() >> v) { 
+    return _queue->at(_pos) >> v; 
+  }
+private:
+  pop_slot(const pop_slot&);
+  pop_slot& operator= (const pop_slot&);
+
+  Q* _queue;
+  std::size_t _pos;
+};
+
+// a run of consecutive slots, published (Push) or released when destroyed
+template<class Q, bool Push> struct queue_batch {
+  typedef typename Q::value_type T;
+
+  queue_batch(Q* q, std::size_t pos, std::size_t n): _queue(q), _pos(pos), _size(n) {}
+  queue_batch(queue_batch&& other): _queue(other._queue), _pos(other._pos), _size(other._size) { other._size = 0; }
+  ~queue_batch() { if (_size) done(std::integral_constant<bool, Push>()); }
+
+  std::size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  T& operator[](std::size_t i) const { return _queue->at(_pos + i); }
+private:
+  void done(std::true_type) { _queue->publish(_pos, _size); }
+  void done(std::false_type) { _queue->release(_pos, _size); }
+
+  queue_batch(const queue_batch&);
+  queue_batch& operator= (const queue_batch&);
+
+  Q* _queue;
+  std::size_t _pos;
+  std::size_t _size;
+};
+
+// the indices written by different threads get their own cache lines, 
+// members after them start on the next line
+struct alignas(64) queue_index {
+  std::atomic<std::size_t> value;
+  queue_index(): value(0) {}
+};
+static_assert(sizeof(queue_index) == 64, "queue_index fills a cache line");
+
+inline std::size_t queue_capacity(std::size_t capacity) {
+  std::size_t c = 2;
+  while (c < capacity) c *= 2;
+  return c;
+}
+
+//////////////////////// queue_front
+
+// push / pop on top of the claim / publish / acquire / release of Q
+template<class Q, class T> struct queue_front {
+  typedef T value_type;
+  typedef tuple_details::push_slot<Q> push_slot;
+  typedef tuple_details::pop_slot<Q> pop_slot;
+  typedef queue_batch<Q, true> push_batch;
+  typedef queue_batch<Q, false> pop_batch;
+
+  push_slot try_push() {
+    std::size_t pos, claimed = self().claim(pos, 1);
+    return push_slot(claimed ? &self() : 0, pos);
+  }
+  push_slot push() {
+    std::size_t pos;
+    while (!self().claim(pos, 1)) std::this_thread::yield();
+    return push_slot(&self(), pos);
+  }
+  push_batch try_push(std::size_t n) {
+    std::size_t pos, claimed = self().claim(pos, n);
+    return push_batch(&self(), pos, claimed);
+  }
+
+  pop_slot try_pop() {
+    std::size_t pos, acquired = self().acquire(pos, 1);
+    return pop_slot(acquired ? &self() : 0, pos);
+  }
+  pop_slot pop() {
+    std::size_t pos;
+    while (!self().acquire(pos, 1)) std::this_thread::yield();
+    return pop_slot(&self(), pos);
+  }
+  pop_batch try_pop(std::size_t n) {
+    std::size_t pos, acquired = self().acquire(pos, n);
+    return pop_batch(&self(), pos, acquired);
+  }
+private:
+  Q& self() { return static_cast<Q&>(*this); }
+};
+
+//////////////////////// spsc_queue
+
+// One producer thread and one consumer thread. Each side keeps a copy of 
+// the other side's index and only reloads it when the copy says the ring 
+// is full (or empty).
+
+template<class T> struct spsc_queue : queue_front<spsc_queue<T>, T> {
+  explicit spsc_queue(std::size_t capacity): 
+    _slots(queue_capacity(capacity)), _mask(_slots.size() - 1), _head_cache(0), _tail_cache(0) {}
+
+  std::size_t capacity() const { return _slots.size(); }
+  T& at(std::size_t pos) { return _slots[pos & _mask]; }
+
+  // producer: up to n free slots starting at pos
+  std::size_t claim(std::size_t& pos, std::size_t n) {
+    pos = _tail.value.load(std::memory_order_relaxed);
+    std::size_t free = capacity() - (pos - _head_cache);
+    if (free < n) {
+      _head_cache = _head.value.load(std::memory_order_acquire);
+      free = capacity() - (pos - _head_cache);
+    }
+    return n < free ? n : free;
+  }
+  void publish(std::size_t pos, std::size_t n) { _tail.value.store(pos + n, std::memory_order_release); }
+
+  // consumer: up to n filled slots starting at pos
+  std::size_t acquire(std::size_t& pos, std::size_t n) {
+    pos = _head.value.load(std::memory_order_relaxed);
+    std::size_t filled = _tail_cache - pos;
+    if (filled < n) {
+      _tail_cache = _tail.value.load(std::memory_order_acquire);
+      filled = _tail_cache - pos;
+    }
+    return n < filled ? n : filled;
+  }
+  void release(std::size_t pos, std::size_t n) { _head.value.store(pos + n, std::memory_order_release); }
+
+private:
+  std::vector<T> _slots;       // read by both, on a line of its own
+  std::size_t _mask;
+  queue_index _head;          // written by the consumer
+  std::size_t _head_cache;    // the producer's copy
+  queue_index _tail;          // written by the producer
+  std::size_t _tail_cache;    // the consumer's copy
+};
+
+//////////////////////// mpmc_queue
+
+// Any number of producers and consumers (D. Vyukov's bounded queue). Every
+// slot has a sequence number telling whose turn it is: pos when it is free 
+// for the producer of pos, pos + 1 when it is filled for the consumer of 
+// pos. A producer (consumer) takes slots by advancing the tail (head) with 
+// compare and swap - a batch takes as many consecutive slots as are ready.
+
+template<class T> struct mpmc_queue : queue_front<mpmc_queue<T>, T> {
+  explicit mpmc_queue(std::size_t capacity): _slots(queue_capacity(capacity)), _mask(_slots.size() - 1) {
+    for (std::size_t i = 0; i < _slots.size(); ++i) _slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  std::size_t capacity() const { return _slots.size(); }
+  T& at(std::size_t pos) { return _slots[pos & _mask].value; }
+
+  std::size_t claim(std::size_t& pos, std::size_t n) { return take(_tail, pos, n, 0); }
+  void publish(std::size_t pos, std::size_t n) { 
+    for (std::size_t i = 0; i < n; ++i) slot(pos + i).sequence.store(pos + i + 1, std::memory_order_release);
+  }
+
+  std::size_t acquire(std::size_t& pos, std::size_t n) { return take(_head, pos, n, 1); }
+  void release(std::size_t pos, std::size_t n) { 
+    for (std::size_t i = 0; i < n; ++i) slot(pos + i).sequence.store(pos + i + capacity(), std::memory_order_release);
+  }
+
+private:
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+  cell& slot(std::size_t pos) { return _slots[pos & _mask]; }
+
+  // slots whose sequence is their position + turn
+  std::size_t take(queue_index& index, std::size_t& pos, std::size_t n, std::size_t turn) {
+    pos = index.value.load(std::memory_order_relaxed);
+    for (;;) {
+      std::size_t k = 0;
+      while (k < n && k < capacity() && slot(pos + k).sequence.load(std::memory_order_acquire) == pos + k + turn) ++k;
+      if (k) {
+        if (index.value.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) return k;
+      } else {
+        std::size_t sequence = slot(pos).sequence.load(std::memory_order_acquire);
+        if ((std::ptrdiff_t)(sequence - (pos + turn)) < 0) return 0; // full (empty)
+        pos = index.value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::vector<cell> _slots;    // read by every thread, on a line of its own
+  std::size_t _mask;
+  queue_index _head;
+  queue_index _tail;
+};
+
+} // namespace tuple_details
+
+// lifting the queues to tbd namespace
+using tuple_details::spsc_queue;
+using tuple_details::mpmc_queue;
+
+} // namspace tbd
+
+#endif // __tuple_queue_h__
@@ -0,0 +1,125 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "tuple_queue.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::spsc_queue;
+using tbd::mpmc_queue;
+
+typedef tuple<int, string, double> record;
+
+// one producer sends 0..n-1, the consumers check the order per producer and the sum
+template<class Q> long long transfer(Q& queue, int producers, int consumers, int n, std::size_t batch) {
+  vector<std::thread> threads;
+  vector<long long> sums(consumers, 0);
+  for (int p = 0; p < producers; ++p) {
+    threads.push_back(std::thread([&queue, p, n, batch]() {
+      for (int i = 0; i < n;) {
+        if (batch == 1) {
+          queue.push() << i | "p" + std::to_string(p) | p * 0.5;
+          ++i;
+        } else {
+          typename Q::push_batch slots = queue.try_push(std::min<std::size_t>(batch, n - i));
+          for (std::size_t j = 0; j < slots.size(); ++j, ++i) slots[j] << i | "p" + std::to_string(p) | p * 0.5;
+          if (slots.empty()) std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  for (int c = 0; c < consumers; ++c) {
+    threads.push_back(std::thread([&queue, &sums, c, producers]() {
+      vector<int> last(producers, -1);
+      int i;
+      string name;
+      double d;
+      for (;;) {
+        queue.pop() >> i | name | d;
+        if (i < 0) break;
+        int p = std::stoi(name.substr(1));
+        assert(d == p * 0.5 && i > last[p]);
+        last[p] = i;
+        sums[c] += i;
+      }
+    }));
+  }
+  for (int p = 0; p < producers; ++p) threads[p].join();
+  // -1 ends one consumer
+  for (int c = 0; c < consumers; ++c) queue.push() << -1 | "" | 0.0;
+  for (std::size_t t = producers; t < threads.size(); ++t) threads[t].join();
+  long long sum = 0;
+  for (int c = 0; c < consumers; ++c) sum += sums[c];
+  return sum;
+}
+
+int main() {
+  spsc_queue<record> spsc(5);
+  assert(spsc.capacity() == 8);
+
+  // slots are filled and read in place, full and empty give empty handles
+  assert(!spsc.try_pop());
+  for (int i = 0; i < 8; ++i) {
+    spsc_queue<record>::push_slot slot = spsc.try_push();
+    assert(slot);
+    slot << i | "x" | 1.5;
+  }
+  assert(!spsc.try_push());
+  {
+    spsc_queue<record>::pop_slot first = spsc.try_pop();
+    assert(first && first->get<0>() == 0 && (*first).get<1>() == "x");
+    assert(!spsc.try_push()); // released at the end of the scope
+  }
+  assert(spsc.try_push());
+  int i;
+  string s;
+  spsc.pop() >> i | s | tbd::na;
+  assert(i == 1 && s == "x");
+
+  // batches wrap around the ring
+  {
+    spsc_queue<record>::pop_batch b = spsc.try_pop(100);
+    assert(b.size() == 7 && b[0].get<0>() == 2 && b[6].get<0>() == 0);
+  }
+  assert(spsc.try_pop(100).empty());
+  {
+    spsc_queue<record>::push_batch b = spsc.try_push(100);
+    assert(b.size() == 8);
+    for (std::size_t j = 0; j < b.size(); ++j) b[j] << int(j) | "b" | 0.0;
+  }
+  assert(spsc.try_pop(3).size() == 3);
+  assert(spsc.try_pop(100).size() == 5);
+
+  mpmc_queue<record> mpmc(4);
+  for (int j = 0; j < 4; ++j) mpmc.push() << j | "m" | 2.5;
+  assert(!mpmc.try_push());
+  assert(mpmc.try_push(3).empty());
+  assert(mpmc.try_pop(3).size() == 3);
+  assert(mpmc.try_pop());
+  assert(mpmc.try_pop(3).empty());
+
+  // threads
+  const int n = 20000;
+  const long long expected = (long long)n * (n - 1) / 2;
+  spsc_queue<record> single(64);
+  assert(transfer(single, 1, 1, n, 1) == expected);
+  mpmc_queue<record> multi(64);
+  assert(transfer(multi, 1, 1, n, 1) == expected);
+  mpmc_queue<record> many(128);
+  assert(transfer(many, 4, 1, n, 1) == 4 * expected);
+  assert(transfer(many, 4, 1, n, 16) == 4 * expected);
+  assert(transfer(many, 2, 3, n, 8) == 2 * expected);
+
+  cout << "moved " << 12 * n << " records" << endl;
+  return 0;
+}
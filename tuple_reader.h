@@ -0,0 +1,331 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+#ifndef __tuple_reader_h__
+#define __tuple_reader_h__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tuple.h"
+
+#if __cplusplus >= 201703L
+#  include <string_view>
+#endif
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// parse_field
+
+// reads a single field into a tuple element, returns false if the text is 
+// not a valid value. Use std::string_view elements to refer to the input 
+// instead of copying and ignore elements to skip a column.
+
+inline bool parse_field(const char* first, const char* last, std::string& value) {
+  value.assign(first, last);
+  return true;
+}
+#if __cpp_lib_string_view
+inline bool parse_field(const char* first, const char* last, std::string_view& value) {
+  value = std::string_view(first, last - first);
+  return true;
+}
+#endif
+inline bool parse_field(const char*, const char*, ignore&) { return true; }
+inline bool parse_field(const char* first, const char* last, char& value) {
+  if (last - first != 1) return false;
+  value = *first;
+  return true;
+}
+inline bool parse_field(const char* first, const char* last, bool& value) {
+  std::size_t n = last - first;
+  if ((n == 1 && *first == '1') || (n == 4 && !std::memcmp(first, "true", 4))) value = true;
+  else if ((n == 1 && *first == '0') || (n == 5 && !std::memcmp(first, "false", 5))) value = false;
+  else return false;
+  return true;
+}
+
+template<class V> inline bool parse_field(const char* first, const char* last, V& value, std::false_type) {
+  std::istringstream _sstr(std::string(first, last));
+  _sstr >> value;
+  return !_sstr.fail();
+}
+template<class V> inline bool parse_field(const char* first, const char* last, V& value, std::true_type) {
+#if TBD_TUPLE_HAS_CHARCONV
+  if (first != last && *first == '+') ++first;
+  std::from_chars_result r = std::from_chars(first, last, value);
+  return r.ec == std::errc() && r.ptr == last;
+#else
+  return parse_field(first, last, value, std::false_type());
+#endif
+}
+template<class V> inline bool parse_field(const char* first, const char* last, V& value) {
+  return parse_field(first, last, value, is_number<V>());
+}
+
+//////////////////////// text_format
+
+struct text_format {
+  text_format(char separator = ',', char quote = '"'): separator(separator), quote(quote) {}
+  char separator;
+  char quote;     // 0 turns quoting off
+};
+
+//////////////////////// field cursor
+
+// splits a single record into fields. Quoted fields are unescaped in place
+// ("a ""b""" becomes a "b") so the input has to be writable.
+struct field_cursor {
+  field_cursor(char* first, char* last, const text_format& format): 
+    _pos(first), _end(last), _format(format), _more(true) {}
+
+  bool next(char*& first, char*& last) {
+    if (!_more) return false;
+    bool quoted = _format.quote && _pos != _end && *_pos == _format.quote;
+    if (quoted) {
+      char* out = first = ++_pos;
+      while (_pos != _end) {
+        if (*_pos == _format.quote) {
+          if (_pos + 1 == _end || _pos[1] != _format.quote) { ++_pos; break; }
+          ++_pos;
+        }
+        if (out != _pos) *out = *_pos;
+        ++out; ++_pos;
+      }
+      last = out;
+    }
+    char* sep = (char*)std::memchr(_pos, _format.separator, _end - _pos);
+    if (!quoted) {
+      first = _pos;
+      last = sep ? sep : _end;
+    }
+    _pos = sep ? sep + 1 : _end;
+    _more = sep != 0;
+    return true;
+  }
+private:
+  char* _pos;
+  char* _end;
+  const text_format& _format;
+  bool _more;
+};
+
+// visitor filling the elements of a tuple from the fields of a record
+struct field_reader {
+  field_reader(field_cursor& cursor): _cursor(cursor), valid(true) {}
+  template<class V> void operator() (V& value, int) {
+    char* first; char* last;
+    if (!_cursor.next(first, last) || !parse_field(first, last, value)) valid = false;
+  }
+private:
+  field_cursor& _cursor;
+public:
+  bool valid;
+};
+
+//////////////////////// text_parser
+
+// Parses delimited text (one record per line, \r\n is fine) into tuples. The 
+// input is either fed in chunks - records may span chunks - or handed over 
+// as a complete writable range (e.g. a mapped_file). string_view fields 
+// point into the input, with fed input they stay valid until the next feed.
+//
+//   tuple<int, ignore, double> row;   // the second column is skipped
+//   while (parser.next(row)) ...
+//
+// Fields past the end of the tuple are ignored, missing or unreadable fields
+// leave the element unchanged and make valid() return false.
+
+struct text_parser {
+  explicit text_parser(text_format format = text_format()): 
+    _format(format), _pos(0), _end(0), _finished(false), _valid(true) {}
+  text_parser(char* first, char* last, text_format format = text_format()): 
+    _format(format), _pos(first), _end(last), _finished(true), _valid(true) {}
+
+  // appends a chunk of input
+  void feed(const char* data, std::size_t n) {
+    std::memcpy(prepare(n), data, n);
+    commit(n);
+  }
+  // returns space for n more bytes of input, call commit with what was used
+  char* prepare(std::size_t n) {
+    std::size_t used = _end - _pos;
+    if (_pos != _buffer.data()) {
+      if (used) std::memmove(_buffer.data(), _pos, used);
+    }
+    if (_buffer.size() < used + n) _buffer.resize(std::max(used + n, 2 * _buffer.size()));
+    _pos = _buffer.data();
+    _end = _pos + used;
+    return _end;
+  }
+  void commit(std::size_t n) { _end += n; }
+  // no more input, the last record does not need a line end
+  void finish() { _finished = true; }
+
+  // parses the next record into tuple, false if there is no complete record
+  template<class T> bool next(T& tuple) {
+    char* first; char* last;
+    if (!find(first, last)) return false;
+    field_cursor cursor(first, last, _format);
+    field_reader reader(cursor);
+    tuple_accept(tuple, reader);
+    _valid = reader.valid;
+    return true;
+  }
+  // skips a record (e.g. a header line)
+  bool skip() {
+    char* first; char* last;
+    return find(first, last);
+  }
+
+  bool valid() const { return _valid; }
+  bool finished() const { return _finished; }
+  bool done() const { return _finished && _pos == _end; }
+private:
+  // the end of the record starting at pos or 0 if it is not complete
+  char* record_end(char* pos, char* end) const {
+    char* eol = (char*)std::memchr(pos, '\n', end - pos);
+    if (!_format.quote || !std::memchr(pos, _format.quote, (eol ? eol : end) - pos)) return eol;
+    for (bool quoted = false; pos != end; ++pos) {
+      if (*pos == _format.quote) quoted = !quoted;
+      else if (*pos == '\n' && !quoted) return pos;
+    }
+    return 0;
+  }
+
+  bool find(char*& first, char*& last) {
+    while (_pos != _end) {
+      char* eol = record_end(_pos, _end);
+      if (!eol && !_finished) return false;
+      first = _pos;
+      last = eol ? eol : _end;
+      _pos = eol ? eol + 1 : _end;
+      if (last != first && last[-1] == '\r') --last;
+      if (last != first) return true;  // skip empty lines
+    }
+    return false;
+  }
+
+  text_format _format;
+  std::vector<char> _buffer;
+  char* _pos;
+  char* _end;
+  bool _finished;
+  bool _valid;
+};
+
+//////////////////////// text_reader
+
+// reads records from a file descriptor in chunks
+struct text_reader {
+  explicit text_reader(int fd, text_format format = text_format(), std::size_t chunk = 1 << 16): 
+    _fd(fd), _parser(format), _chunk(chunk ? chunk : 1), _good(true) {}
+
+  template<class T> bool read(T& tuple) {
+    while (!_parser.next(tuple)) {
+      if (_parser.finished()) return false;
+      fill();
+    }
+    return true;
+  }
+  bool skip() {
+    while (!_parser.skip()) {
+      if (_parser.finished()) return false;
+      fill();
+    }
+    return true;
+  }
+
+  bool valid() const { return _parser.valid(); }
+  // false if reading from the descriptor failed
+  bool good() const { return _good; }
+private:
+  void fill() {
+    char* data = _parser.prepare(_chunk);
+    ssize_t n;
+    do n = ::read(_fd, data, _chunk); while (n < 0 && errno == EINTR);
+    if (n > 0) {
+      _parser.commit(n);
+      return;
+    }
+    if (n < 0) _good = false;
+    _parser.finish();
+  }
+
+  int _fd;
+  text_parser _parser;
+  std::size_t _chunk;
+  bool _good;
+};
+
+//////////////////////// mapped_file
+
+// Maps a whole file copy-on-write (the parser may unescape quoted fields in 
+// place without touching the file). Hand data() and data() + size() to a 
+// text_parser to parse it without copying.
+
+struct mapped_file {
+  explicit mapped_file(const char* path): _data(0), _size(0) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (!::fstat(fd, &st) && st.st_size > 0) {
+      void* p = ::mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+        _data = (char*)p;
+        _size = st.st_size;
+      }
+    }
+    ::close(fd);
+  }
+  ~mapped_file() { if (_data) ::munmap(_data, _size); }
+
+  char* data() const { return _data; }
+  std::size_t size() const { return _size; }
+  bool good() const { return _data != 0; }
+private:
+  mapped_file(const mapped_file&); // no copies
+  mapped_file& operator= (const mapped_file&);
+
+  char* _data;
+  std::size_t _size;
+};
+
+} // namespace tuple_details
+
+// lifting the reader types to tbd namespace
+using tuple_details::text_format;
+using tuple_details::text_parser;
+using tuple_details::text_reader;
+using tuple_details::mapped_file;
+
+} // namspace tbd
+
+#endif // __tuple_reader_h__
@@ -0,0 +1,104 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "tuple_reader.h"
+#include "tuple_writer.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::text_format;
+using tbd::text_parser;
+using tbd::text_reader;
+using tbd::text_writer;
+using tbd::mapped_file;
+
+const char csv[] = 
+  "id,name,weight\r\n"
+  "42,sally,47.11\r\n"
+  "\n"
+  "7,\"harry \"\"the hat\"\", jr\",80.5\n"
+  "9,\"two\nlines\",1e3\n"
+  "x,broken,1\n"
+  "11,last,0.5";
+
+// parses csv fed in chunks of the given size
+void parse_chunks(std::size_t chunk) {
+  typedef tuple<int, string, double> user;
+  user sally(accu << 42 | "sally" | 47.11);
+  text_parser parser;
+  user row;
+  int rows = 0;
+  bool header = false;
+
+  for (std::size_t pos = 0; pos < sizeof(csv) - 1 || !parser.finished(); pos += chunk) {
+    if (pos < sizeof(csv) - 1) parser.feed(csv + pos, std::min(chunk, sizeof(csv) - 1 - pos));
+    else parser.finish();
+
+    if (!header) header = parser.skip();
+    while (header && parser.next(row)) {
+      switch (rows++) {
+        case 0: assert(parser.valid() && row == sally); break;
+        case 1: assert(parser.valid() && row.get<1>() == "harry \"the hat\", jr" && row.get<2>() == 80.5); break;
+        case 2: assert(parser.valid() && row.get<1>() == "two\nlines" && row.get<2>() == 1000.0); break;
+        case 3: assert(!parser.valid()); break;
+        case 4: assert(parser.valid() && row.get<0>() == 11 && row.get<1>() == "last"); break;
+      }
+    }
+  }
+  assert(rows == 5 && parser.done());
+}
+
+int main() {
+  for (std::size_t chunk = 1; chunk <= sizeof(csv); chunk *= 2) parse_chunks(chunk);
+
+  // ignore skips a column, string_view refers to the input instead of copying it
+  char text[] = "1;skip;\"a;b\"\n2;skip;c\n";
+  text_parser parser(text, text + std::strlen(text), text_format(';'));
+#if __cpp_lib_string_view
+  tuple<int, tbd::ignore, std::string_view> view;
+  assert(parser.next(view) && view.get<0>() == 1 && view.get<2>() == "a;b");
+  assert(view.get<2>().data() > text && view.get<2>().data() < text + sizeof(text));
+#else
+  tuple<int, tbd::ignore, string> view;
+  assert(parser.next(view) && view.get<0>() == 1 && view.get<2>() == "a;b");
+#endif
+  assert(parser.next(view) && view.get<2>() == "c" && !parser.next(view) && parser.done());
+
+  // write rows to a file and read them back with text_reader and mapped_file
+  char name[] = "/tmp/tuple_reader_test_XXXXXX";
+  int fd = mkstemp(name);
+  assert(fd >= 0);
+  {
+    text_writer out(fd);
+    for (int i = 0; i < 10000; ++i) out.write(tuple<int, string, double>(accu << i | "row" | i * 0.5), "\t");
+  }
+
+  lseek(fd, 0, SEEK_SET);
+  text_reader in(fd, text_format('\t'), 100);
+  tuple<int, string, double> row;
+  int rows = 0;
+  while (in.read(row)) {
+    assert(in.valid() && row.get<0>() == rows && row.get<2>() == rows * 0.5);
+    ++rows;
+  }
+  assert(rows == 10000 && in.good());
+
+  mapped_file file(name);
+  assert(file.good());
+  text_parser mapped(file.data(), file.data() + file.size(), text_format('\t'));
+  for (rows = 0; mapped.next(row); ++rows) assert(mapped.valid() && row.get<0>() == rows);
+  assert(rows == 10000);
+
+  close(fd);
+  unlink(name);
+  cout << "parsed " << rows << " rows" << endl;
+  return 0;
+}
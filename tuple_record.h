@@ -0,0 +1,355 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+#ifndef __tuple_record_h__
+#define __tuple_record_h__
+
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include "tuple.h"
+#include "tuple_reader.h"
+#include "tuple_writer.h"
+
+#if __cplusplus >= 201703L
+#  include <string_view>
+#endif
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// binary_field
+
+// How an element type is stored. Fixed fields (numbers and enums) have a 
+// fixed size and offset in every record, variable fields (strings, vectors 
+// of numbers) are stored as a 32 bit byte length followed by the bytes. 
+// Everything is stored in native byte order.
+
+typedef unsigned int record_size_type;
+
+// the largest record (without its size), longer ones are not encoded
+const std::size_t max_record_size = record_size_type(-1);
+
+inline record_size_type read_size(const char* p) {
+  record_size_type n;
+  std::memcpy(&n, p, sizeof(n));
+  return n;
+}
+
+template<class V, class = void> struct binary_field; // not supported
+
+template<class V> struct binary_field<V, 
+  typename std::enable_if<std::is_arithmetic<V>::value || std::is_enum<V>::value>::type> {
+  enum { fixed = 1, size = sizeof(V) };
+  static void write(char* p, const V& v) { std::memcpy(p, &v, sizeof(V)); }
+  static void read(const char* p, V& v) { std::memcpy(&v, p, sizeof(V)); }
+};
+
+template<> struct binary_field<std::string> {
+  enum { fixed = 0, size = 0 };
+  static std::size_t length(const std::string& v) { return v.size(); }
+  static const char* bytes(const std::string& v) { return v.data(); }
+  static void read(const char* p, std::size_t n, std::string& v) { v.assign(p, n); }
+};
+
+#if __cpp_lib_string_view
+template<> struct binary_field<std::string_view> {
+  enum { fixed = 0, size = 0 };
+  static std::size_t length(const std::string_view& v) { return v.size(); }
+  static const char* bytes(const std::string_view& v) { return v.data(); }
+  static void read(const char* p, std::size_t n, std::string_view& v) { v = std::string_view(p, n); }
+};
+#endif
+
+template<class E> struct binary_field<std::vector<E>, 
+  typename std::enable_if<binary_field<E>::fixed>::type> {
+  enum { fixed = 0, size = 0 };
+  static std::size_t length(const std::vector<E>& v) { return v.size() * sizeof(E); }
+  static const char* bytes(const std::vector<E>& v) { return (const char*)v.data(); }
+  static void read(const char* p, std::size_t n, std::vector<E>& v) { 
+    v.resize(n / sizeof(E)); 
+    if (!v.empty()) std::memcpy(v.data(), p, v.size() * sizeof(E));
+  }
+};
+
+//////////////////////// binary_layout
+
+// fixed_size is the size of the fixed block of T, variable the number of 
+// variable fields. The offset of element C is what the elements before C 
+// add to these.
+
+template<class T> struct binary_layout {
+  typedef binary_field<typename T::head_type> field;
+  typedef binary_layout<typename T::tail_type> tail;
+  enum { 
+    fixed_size = (int)field::size + (int)tail::fixed_size, 
+    variable = !field::fixed + (int)tail::variable 
+  };
+};
+template<> struct binary_layout<tuple_end> { enum { fixed_size = 0, variable = 0 }; };
+
+template<int C, class T> struct binary_offset {
+  typedef typename tuple_element<C, T>::type sub;
+  enum { 
+    fixed = (int)binary_layout<T>::fixed_size - (int)binary_layout<sub>::fixed_size,
+    variable = (int)binary_layout<T>::variable - (int)binary_layout<sub>::variable
+  };
+};
+
+//////////////////////// encode
+
+// a record is [size][fixed fields][length, bytes of each variable field] 
+// where size (32 bit) counts the bytes following it, so a record (and every 
+// field in it) is limited to max_record_size bytes
+
+template<class Sink, class V> inline void encode_fixed(Sink& out, const V& v, std::true_type) {
+  char buffer[binary_field<V>::size];
+  binary_field<V>::write(buffer, v);
+  out.append(buffer, sizeof(buffer));
+}
+template<class Sink, class V> inline void encode_fixed(Sink&, const V&, std::false_type) {}
+template<class Sink> inline void encode_fixed(Sink&, const tuple_end&) {}
+template<class Sink, class T> inline void encode_fixed(Sink& out, const T& t) {
+  typedef typename T::head_type head_type;
+  encode_fixed(out, t.head(), std::integral_constant<bool, binary_field<head_type>::fixed>());
+  encode_fixed(out, t.tail());
+}
+
+template<class Sink, class V> inline void encode_variable(Sink&, const V&, std::true_type) {}
+template<class Sink, class V> inline void encode_variable(Sink& out, const V& v, std::false_type) {
+  record_size_type n = (record_size_type)binary_field<V>::length(v);
+  out.append((const char*)&n, sizeof(n));
+  out.append(binary_field<V>::bytes(v), n);
+}
+template<class Sink> inline void encode_variable(Sink&, const tuple_end&) {}
+template<class Sink, class T> inline void encode_variable(Sink& out, const T& t) {
+  typedef typename T::head_type head_type;
+  encode_variable(out, t.head(), std::integral_constant<bool, binary_field<head_type>::fixed>());
+  encode_variable(out, t.tail());
+}
+
+template<class V> inline std::size_t variable_size(const V&, std::true_type) { return 0; }
+template<class V> inline std::size_t variable_size(const V& v, std::false_type) { 
+  return sizeof(record_size_type) + binary_field<V>::length(v); 
+}
+inline std::size_t variable_size(const tuple_end&) { return 0; }
+template<class T> inline std::size_t variable_size(const T& t) {
+  typedef typename T::head_type head_type;
+  return variable_size(t.head(), std::integral_constant<bool, binary_field<head_type>::fixed>()) + 
+    variable_size(t.tail());
+}
+
+// appends the record of tuple to out (anything with append(const char*, size_t)),
+// false and nothing appended if the record is longer than max_record_size
+template<class Sink, class T> inline bool encode(Sink& out, const T& tuple) {
+  typedef typename T::value_type value_type;
+  const value_type& v = tuple;
+  const std::size_t n = binary_layout<value_type>::fixed_size + variable_size(v);
+  if (n > max_record_size) return false;
+  record_size_type size = (record_size_type)n;
+  out.append((const char*)&size, sizeof(size));
+  encode_fixed(out, v);
+  encode_variable(out, v);
+  return true;
+}
+
+//////////////////////// decode
+
+// the variable field at p if its length and bytes end before end, 0 otherwise
+inline const char* checked_field(const char* p, const char* end) {
+  if (!p || end - p < (std::ptrdiff_t)sizeof(record_size_type)) return 0;
+  return read_size(p) <= std::size_t(end - p) - sizeof(record_size_type) ? p : 0;
+}
+
+template<class V> inline bool decode_field(const char*& fixed, const char*&, const char*, V& v, std::true_type) {
+  binary_field<V>::read(fixed, v);
+  fixed += binary_field<V>::size;
+  return true;
+}
+template<class V> inline bool decode_field(const char*&, const char*& variable, const char* end, V& v, std::false_type) {
+  if (!checked_field(variable, end)) return false;
+  record_size_type n = read_size(variable);
+  binary_field<V>::read(variable + sizeof(n), n, v);
+  variable += sizeof(n) + n;
+  return true;
+}
+inline bool decode_fields(const char*, const char*, const char*, tuple_end&) { return true; }
+template<class T> inline bool decode_fields(const char* fixed, const char* variable, const char* end, T& t) {
+  typedef typename T::head_type head_type;
+  return decode_field(fixed, variable, end, t.head(), std::integral_constant<bool, binary_field<head_type>::fixed>()) &&
+    decode_fields(fixed, variable, end, t.tail());
+}
+
+//////////////////////// record_view
+
+// A record in memory (e.g. inside a mapped record_file). Single elements are 
+// read by get<C> without decoding the rest of the record, variable fields can 
+// be looked at without copying them using bytes<C> (or view<C> with C++17).
+// Nothing is read beyond size(): a field that does not fit into the record 
+// reads as default constructed (bytes<C> as 0, 0) and decode returns false.
+
+template<class T> struct record_view {
+  typedef T tuple_type;
+  typedef typename tuple_type::value_type value_type;
+  typedef binary_layout<value_type> layout;
+
+  explicit record_view(const char* data): _data(data) {}
+
+  template<int C> struct element { 
+    typedef typename tuple_element<C, value_type>::type::head_type type; 
+  };
+
+  const char* data() const { return _data; }
+  // the bytes of the whole record including its size
+  std::size_t size() const { return sizeof(record_size_type) + read_size(_data); }
+
+  template<int C> typename element<C>::type get() const {
+    typedef typename element<C>::type V;
+    V value = V();
+    if (complete()) read<C>(value, std::integral_constant<bool, binary_field<V>::fixed>());
+    return value;
+  }
+
+  // the stored bytes of the variable field C
+  template<int C> std::pair<const char*, std::size_t> bytes() const {
+    const char* p = variable<C>();
+    if (!p) return std::pair<const char*, std::size_t>(0, 0);
+    return std::make_pair(p + sizeof(record_size_type), (std::size_t)read_size(p));
+  }
+#if __cpp_lib_string_view
+  template<int C> std::string_view view() const {
+    std::pair<const char*, std::size_t> b = bytes<C>();
+    return std::string_view(b.first, b.second);
+  }
+#endif
+
+  // false if the record is too short for its fields, tuple is partly filled then
+  bool decode(value_type& tuple) const {
+    if (!complete()) return false;
+    const char* fixed = _data + sizeof(record_size_type);
+    return decode_fields(fixed, fixed + layout::fixed_size, _data + size(), tuple);
+  }
+  tuple_type value() const {
+    tuple_type t;
+    decode(t);
+    return t;
+  }
+private:
+  template<int C, class V> void read(V& value, std::true_type) const {
+    binary_field<V>::read(_data + sizeof(record_size_type) + binary_offset<C, value_type>::fixed, value);
+  }
+  template<int C, class V> void read(V& value, std::false_type) const {
+    if (const char* p = variable<C>()) binary_field<V>::read(p + sizeof(record_size_type), read_size(p), value);
+  }
+  // the fixed fields fit into the record
+  bool complete() const { return read_size(_data) >= std::size_t(layout::fixed_size); }
+  // start of the variable field C: skip the lengths of the ones before, 0 if 
+  // one of them (or C itself) does not fit into the record
+  template<int C> const char* variable() const {
+    if (!complete()) return 0;
+    const char* end = _data + size();
+    const char* p = _data + sizeof(record_size_type) + layout::fixed_size;
+    for (int i = 0; i < binary_offset<C, value_type>::variable; ++i) {
+      if (!checked_field(p, end)) return 0;
+      p += sizeof(record_size_type) + read_size(p);
+    }
+    return checked_field(p, end);
+  }
+
+  const char* _data;
+};
+
+//////////////////////// record_writer
+
+// appends the records of tuples to a file descriptor, good() is false once 
+// a write failed or a tuple was too long for a record
+struct record_writer {
+  explicit record_writer(int fd, std::size_t capacity = 1 << 16): _out(fd, capacity), _fits(true) {}
+
+  template<class T> record_writer& write(const T& tuple) { 
+    if (!encode(_out, tuple)) _fits = false; 
+    return *this; 
+  }
+  bool flush() { return _out.flush() && _fits; }
+  bool good() const { return _out.good() && _fits; }
+private:
+  text_writer _out;
+  bool _fits;
+};
+
+//////////////////////// record_file
+
+// Maps a file written by record_writer and iterates its records in place. 
+// Iteration stops at a truncated record.
+
+template<class T> struct record_file {
+  typedef record_view<T> value_type;
+
+  struct iterator {
+    typedef std::forward_iterator_tag iterator_category;
+    typedef record_view<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef value_type reference;
+
+    iterator(const char* pos, const char* end): _pos(pos), _end(end) { check(); }
+
+    value_type operator*() const { return value_type(_pos); }
+    iterator& operator++() { 
+      _pos += sizeof(record_size_type) + read_size(_pos); 
+      check(); 
+      return *this; 
+    }
+    iterator operator++(int) { iterator i(*this); ++*this; return i; }
+
+    bool operator==(const iterator& other) const { return _pos == other._pos; }
+    bool operator!=(const iterator& other) const { return _pos != other._pos; }
+  private:
+    void check() {
+      std::size_t left = _end - _pos;
+      if (left < sizeof(record_size_type) || left - sizeof(record_size_type) < read_size(_pos)) _pos = _end;
+    }
+    const char* _pos;
+    const char* _end;
+  };
+
+  explicit record_file(const char* path): _file(path) {}
+
+  bool good() const { return _file.good(); }
+  iterator begin() const { return iterator(_file.data(), _file.data() + _file.size()); }
+  iterator end() const { return iterator(_file.data() + _file.size(), _file.data() + _file.size()); }
+private:
+  mapped_file _file;
+};
+
+} // namespace tuple_details
+
+// lifting the record types to tbd namespace
+using tuple_details::encode;
+using tuple_details::record_view;
+using tuple_details::record_writer;
+using tuple_details::record_file;
+
+} // namspace tbd
+
+#endif // __tuple_record_h__
@@ -0,0 +1,112 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "tuple_record.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::record_view;
+using tbd::record_writer;
+using tbd::record_file;
+
+enum color { red, green, blue };
+
+// pretends to be too large for a record
+struct huge {};
+namespace tbd { namespace tuple_details {
+template<> struct binary_field<huge> {
+  enum { fixed = 0, size = 0 };
+  static std::size_t length(const huge&) { return std::size_t(5) << 30; }
+  static const char* bytes(const huge&) { return 0; }
+  static void read(const char*, std::size_t, huge&) {}
+};
+} }
+
+int main() {
+  typedef tuple<int, string, double, vector<short>, color, string> row;
+  vector<short> shorts;
+  shorts.push_back(1);
+  shorts.push_back(-2);
+
+  // fixed fields first (4 + 8 + 4 bytes), then the variable ones with their length
+  row r(accu << 42 | "sally" | 47.11 | shorts | blue | "");
+  string buffer;
+  tbd::encode(buffer, r);
+  assert(buffer.size() == 4 + 16 + (4 + 5) + (4 + 4) + (4 + 0));
+
+  record_view<row> view(buffer.data());
+  assert(view.size() == buffer.size());
+  assert(view.get<0>() == 42 && view.get<2>() == 47.11 && view.get<4>() == blue);
+  assert(view.get<1>() == "sally" && view.get<3>() == shorts && view.get<5>().empty());
+  assert(view.bytes<1>().second == 5 && string(view.bytes<1>().first, 5) == "sally");
+  assert(view.value() == r);
+
+  // lengths that point beyond the record are not followed
+  string broken(buffer);
+  tbd::tuple_details::record_size_type too_long = 1000;
+  std::memcpy(&broken[4 + 16 + 4 + 5], &too_long, sizeof(too_long));
+  record_view<row> bad(broken.data());
+  assert(bad.get<1>() == "sally" && bad.get<3>().empty() && bad.get<5>().empty());
+  assert(bad.bytes<3>().first == 0 && bad.bytes<5>().second == 0);
+  row partly;
+  assert(!bad.decode(partly.value()) && partly.get<1>() == "sally");
+  tbd::tuple_details::record_size_type too_short = 8;
+  std::memcpy(&broken[0], &too_short, sizeof(too_short));
+  assert(record_view<row>(broken.data()).get<2>() == 0.0 && !record_view<row>(broken.data()).decode(partly.value()));
+
+  // records longer than 4 GiB are not written
+  tuple<int, huge> large;
+  string out;
+  assert(!tbd::encode(out, large) && out.empty());
+  {
+    record_writer devnull(-1);
+    assert(!devnull.write(large).good());
+  }
+
+  // records written to a file are read in place
+  char name[] = "/tmp/tuple_record_test_XXXXXX";
+  int fd = mkstemp(name);
+  assert(fd >= 0);
+  {
+    record_writer out(fd);
+    for (int i = 0; i < 1000; ++i) out.write(row(accu << i | string(i % 10, 'x') | i * 0.5 | shorts | red | "end"));
+    assert(out.flush() && out.good());
+  }
+
+  record_file<row> file(name);
+  assert(file.good());
+  int n = 0;
+  row decoded;
+  for (record_file<row>::iterator i = file.begin(); i != file.end(); ++i, ++n) {
+    assert((*i).get<0>() == n && (*i).get<1>().size() == size_t(n % 10));
+#if __cpp_lib_string_view
+    assert((*i).view<5>() == "end");
+#endif
+    (*i).decode(decoded);
+    assert(decoded.get<2>() == n * 0.5 && decoded.get<3>() == shorts);
+  }
+  assert(n == 1000);
+
+  // a truncated last record ends the iteration
+  assert(ftruncate(fd, lseek(fd, 0, SEEK_END) - 3) == 0);
+  record_file<row> truncated(name);
+  n = 0;
+  for (record_file<row>::iterator i = truncated.begin(); i != truncated.end(); ++i) ++n;
+  assert(n == 999);
+
+  close(fd);
+  unlink(name);
+  cout << "read " << n << " records" << endl;
+  return 0;
+}
@@ -0,0 +1,206 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+
+#ifndef __tuple_select_h__
+#define __tuple_select_h__
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "tuple.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// select_item
+
+// A selection refers to some elements of another tuple (or packed_tuple) in
+// any order, select<2, 0>(t) behaves like tuple<E2&, E0&> without copying 
+// anything. It has head() / tail() like tuple_item, so eq, compare, hash, 
+// accept and visit work on selections as well as on tuples. The selection 
+// must not outlive the tuple.
+
+template<class T, int C> struct selected_type {
+  typedef typename std::remove_reference<decltype(std::declval<T&>().template get<C>())>::type type;
+};
+
+template<class T, int... I> struct select_item;
+
+template<class T> struct select_item<T> {
+  enum { size = 0 };
+  constexpr explicit select_item(T& t): _tuple(&t) {}
+protected:
+  T* _tuple;
+};
+
+template<class T, int I, int... J> struct select_item<T, I, J...> : select_item<T, J...> {
+  enum { size = sizeof...(J) + 1 };
+  typedef typename selected_type<T, I>::type head_type;
+  typedef select_item<T, J...> tail_type;
+
+  constexpr explicit select_item(T& t): tail_type(t) {}
+
+  constexpr head_type& head() const { return this->_tuple->template get<I>(); }
+  constexpr const tail_type& tail() const { return *this; }
+};
+
+template<class T, int I> struct select_item<T, I> : select_item<T> {
+  enum { size = 1 };
+  typedef typename selected_type<T, I>::type head_type;
+  typedef tuple_end tail_type;
+
+  constexpr explicit select_item(T& t): select_item<T>(t) {}
+
+  constexpr head_type& head() const { return this->_tuple->template get<I>(); }
+  constexpr tail_type tail() const { return tail_type(); }
+};
+
+// the C-th of the indices I...
+template<int C, int... I> struct select_index;
+template<int I, int... J> struct select_index<0, I, J...> { enum { value = I }; };
+template<int C, int I, int... J> struct select_index<C, I, J...> { enum { value = select_index<C - 1, J...>::value }; };
+
+//////////////////////// selection
+
+template<class T, int... I> struct selection : select_item<T, I...> {
+  typedef selection<T, I...> self;
+  typedef select_item<T, I...> value_type;
+  // a tuple holding copies of the selected elements
+  typedef tuple<typename std::remove_const<typename selected_type<T, I>::type>::type...> tuple_type;
+
+  constexpr explicit selection(T& t): value_type(t) {}
+  // a selection of a tuple converts to the selection of the const tuple
+  constexpr selection(const selection<typename std::remove_const<T>::type, I...>& s): value_type(s.source()) {}
+
+  template<int C> struct element { 
+    typedef typename selected_type<T, select_index<C, I...>::value>::type type; 
+  };
+
+  template<int C> constexpr typename element<C>::type& get() const { 
+    return this->_tuple->template get<select_index<C, I...>::value>(); 
+  }
+  template<int C> void set(const typename element<C>::type& v) const { get<C>() = v; }
+
+  template<class V> V& accept(V& visitor) const { return tuple_accept(value(), visitor); }
+  template<class V> const V& accept(const V& visitor) const { return tuple_accept(value(), visitor); }
+
+  template<class V> V& visit(V& visitor) const { return tuple_visit(value(), visitor); }
+  template<class V> const V& visit(const V& visitor) const { return tuple_visit(value(), visitor); }
+
+  std::string join(std::string separator = "") const {
+    std::string out;
+    return join_to(out, separator.c_str());
+  }
+  template<class Sink> Sink& join_to(Sink& out, const char* separator = "", const field_format* formats = 0) const {
+    joiner<Sink> visitor(out, separator, formats);
+    tuple_visit(value(), visitor);
+    return out;
+  }
+
+  // copies the selected elements into a plain tuple
+  tuple_type unpack() const { 
+    tuple_type t;
+    unpack_to(t, std::integral_constant<int, 0>());
+    return t; 
+  }
+
+  constexpr const value_type& value() const { return *this; }
+  constexpr T& source() const { return *this->_tuple; }
+
+private:
+  void unpack_to(tuple_type&, std::integral_constant<int, sizeof...(I)>) const {}
+  template<int C> void unpack_to(tuple_type& t, std::integral_constant<int, C>) const {
+    t.template set<C>(get<C>());
+    unpack_to(t, std::integral_constant<int, C + 1>());
+  }
+};
+
+template<int... I, class T> constexpr selection<T, I...> select(T& t) { 
+  return selection<T, I...>(t); 
+}
+
+//////////////////////// selection comparison
+
+// selections compare with selections and tuples of any (convertible) types
+
+template<class T, int... I> constexpr const select_item<T, I...>& select_items(const selection<T, I...>& s) { return s; }
+template<class HT, class TT> constexpr const tuple_item<HT, TT>& select_items(const tuple_item<HT, TT>& t) { return t; }
+
+template<class T, int... I, class R> constexpr 
+bool operator==(const selection<T, I...>& l, const R& r) { return eq(l.value(), select_items(r)); }
+template<class T, int... I, class R> constexpr 
+bool operator!=(const selection<T, I...>& l, const R& r) { return neq(l.value(), select_items(r)); }
+template<class T, int... I, class R> constexpr 
+bool operator< (const selection<T, I...>& l, const R& r) { return lt(l.value(), select_items(r)); }
+template<class T, int... I, class R> constexpr 
+bool operator> (const selection<T, I...>& l, const R& r) { return gt(l.value(), select_items(r)); }
+template<class T, int... I, class R> constexpr 
+bool operator<=(const selection<T, I...>& l, const R& r) { return lte(l.value(), select_items(r)); }
+template<class T, int... I, class R> constexpr 
+bool operator>=(const selection<T, I...>& l, const R& r) { return gte(l.value(), select_items(r)); }
+
+template<class HT, class TT, class T, int... I> constexpr 
+bool operator==(const tuple_item<HT, TT>& l, const selection<T, I...>& r) { return eq(l, r.value()); }
+template<class HT, class TT, class T, int... I> constexpr 
+bool operator!=(const tuple_item<HT, TT>& l, const selection<T, I...>& r) { return neq(l, r.value()); }
+template<class HT, class TT, class T, int... I> constexpr 
+bool operator< (const tuple_item<HT, TT>& l, const selection<T, I...>& r) { return lt(l, r.value()); }
+template<class HT, class TT, class T, int... I> constexpr 
+bool operator> (const tuple_item<HT, TT>& l, const selection<T, I...>& r) { return gt(l, r.value()); }
+template<class HT, class TT, class T, int... I> constexpr 
+bool operator<=(const tuple_item<HT, TT>& l, const selection<T, I...>& r) { return lte(l, r.value()); }
+template<class HT, class TT, class T, int... I> constexpr 
+bool operator>=(const tuple_item<HT, TT>& l, const selection<T, I...>& r) { return gte(l, r.value()); }
+
+//////////////////////// key functors
+
+// orders, compares or hashes tuples by the selected elements only, e.g.
+// std::sort(rows.begin(), rows.end(), select_less<2, 0>())
+template<int... I> struct select_less {
+  template<class T1, class T2> bool operator()(const T1& l, const T2& r) const { 
+    return lt(select<I...>(l).value(), select<I...>(r).value()); 
+  }
+};
+template<int... I> struct select_equal {
+  template<class T1, class T2> bool operator()(const T1& l, const T2& r) const { 
+    return eq(select<I...>(l).value(), select<I...>(r).value()); 
+  }
+};
+template<int... I> struct select_hash {
+  template<class T> std::size_t operator()(const T& t) const { return hash(select<I...>(t).value()); }
+};
+
+} // namespace tuple_details
+
+// lifting the selections to tbd namespace
+using tuple_details::selection;
+using tuple_details::select;
+using tuple_details::select_less;
+using tuple_details::select_equal;
+using tuple_details::select_hash;
+
+} // namspace tbd
+
+#endif // __tuple_select_h__
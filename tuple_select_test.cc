@@ -0,0 +1,105 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+#include "tuple_select.h"
+#include "tuple_packed.h"
+#include "tuple_map.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::select;
+using tbd::packed_tuple;
+
+struct counter {
+  int count;
+  template<class V> void operator() (const V&, int i) { count += i + 1; }
+};
+
+struct indices {
+  string seen;
+  template<class V, std::size_t I> void operator() (const V&, std::integral_constant<std::size_t, I>) { seen += char('0' + I); }
+};
+
+typedef tuple<int, string, double> row;
+static_assert(sizeof(tbd::selection<row, 2, 0, 1>) == sizeof(void*), "");
+static_assert(std::is_same<tbd::selection<const row, 1>::element<0>::type, const string>::value, "");
+static_assert(std::is_same<tbd::selection<row, 2, 0>::tuple_type, tuple<double, int> >::value, "");
+
+int main() {
+  row r(accu << 7 | "seven" | 0.5);
+
+  // elements are referenced, not copied
+  tbd::selection<row, 2, 0> s = select<2, 0>(r);
+  assert(s.get<0>() == 0.5 && s.get<1>() == 7);
+  assert(&select<1>(r).get<0>() == &r.get<1>());
+  s.set<1>(8);
+  s.get<0>() = 1.5;
+  assert(r.get<0>() == 8 && r.get<2>() == 1.5);
+
+  // comparison against tuples and other selections
+  typedef tuple<double, int> key_type;
+  key_type key(accu << 1.5 | 8);
+  assert(s == key && key == s && !(s != key));
+  assert(s < key_type(accu << 1.5 | 9) && key_type(accu << 1.0 | 9) < s);
+  assert(s <= key && s >= key && !(s > key));
+  row other(accu << 3 | "three" | 1.5);
+  tbd::selection<row, 2, 0> o = select<2, 0>(other);
+  assert(o < s && s > o && select<2>(other) == select<2>(r));
+  assert(tbd::compare(s.value(), key) == 0);
+  assert(s.unpack() == key);
+
+  // hash and join see only the selected elements, in selection order
+  assert(tbd::hash(s.value()) == tbd::hash(key));
+  tbd::selection<row, 1, 0> names = select<1, 0>(r);
+  assert(names.join(";") == "seven;8");
+  counter c = { 0 };
+  s.accept(c);
+  assert(c.count == 3);
+  indices v;
+  names.visit(v);
+  assert(v.seen == "01");
+
+  // const tuples give const selections
+  const row& cr = r;
+  static_assert(std::is_same<decltype(select<1>(cr).get<0>()), const string&>::value, "");
+  assert(select<1>(cr) == tuple<string>(accu << "seven"));
+
+  // packed tuples and selections of selections
+  typedef packed_tuple<char, double, char> packed;
+  packed p(accu << 'a' | 2.5 | 'b');
+  typedef tuple<char, char> chars;
+  tbd::selection<packed, 2, 0> ps = select<2, 0>(p);
+  assert(ps == chars(accu << 'b' | 'a'));
+  tbd::selection<row, 2, 0> s2 = s;
+  assert(select<1>(s2).get<0>() == 8);
+
+  // sort and group by fields 2, 0
+  std::vector<row> rows;
+  rows.push_back(accu << 2 | "b" | 1.0);
+  rows.push_back(accu << 1 | "a" | 2.0);
+  rows.push_back(accu << 3 | "c" | 1.0);
+  rows.push_back(accu << 1 | "d" | 1.0);
+  std::sort(rows.begin(), rows.end(), tbd::select_less<2, 0>());
+  assert(rows[0].get<1>() == "d" && rows[1].get<1>() == "b" && rows[2].get<1>() == "c" && rows[3].get<1>() == "a");
+  typedef tbd::select_equal<2, 0> same_key;
+  assert(tbd::select_equal<2>()(rows[0], rows[1]) && !same_key()(rows[0], rows[1]));
+  typedef tbd::select_hash<2, 0> key_hash;
+  assert(key_hash()(rows[0]) == tbd::hash(key_type(accu << 1.0 | 1)));
+
+  // selections as map keys, they point into rows
+  typedef tbd::selection<const row, 2> by_third;
+  tbd::flat_map<by_third, int> groups;
+  for (std::size_t i = 0; i < rows.size(); ++i) ++groups[select<2>(rows[i])];
+  assert(groups.size() == 2 && groups[select<2>(rows[0])] == 3);
+
+  cout << "select<1, 0>: " << names.join(", ") << endl;
+  return 0;
+}
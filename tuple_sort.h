@@ -0,0 +1,274 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+#ifndef __tuple_sort_h__
+#define __tuple_sort_h__
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "tuple.h"
+
+#if __cplusplus >= 201703L
+#  include <string_view>
+#endif
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// key_field
+
+// Appends an element to a normalized key: keys of two tuples compare with 
+// memcmp (a shorter key that matches so far is less) exactly like compare()
+// compares the tuples. Integers are stored big endian with the sign bit 
+// flipped, floating point values with the sign bit flipped (all bits for 
+// negative values, -0.0 is stored as 0.0 and NaN after infinity) and strings
+// are terminated by 00 01 with 00 escaped as 00 ff.
+
+template<class V, class = void> struct key_field; // not supported
+
+template<class Sink, class U> inline void append_big_endian(Sink& out, U u) {
+  char bytes[sizeof(U)];
+  for (int i = sizeof(U) - 1; i >= 0; --i) {
+    bytes[i] = char(u & 0xff);
+    u >>= 8;
+  }
+  out.append(bytes, sizeof(U));
+}
+
+template<class V> struct key_field<V, typename std::enable_if<
+  std::is_integral<V>::value && !std::is_same<V, bool>::value>::type> {
+  template<class Sink> static void append(Sink& out, V v) {
+    typedef typename std::make_unsigned<V>::type U;
+    U u = (U)v;
+    if (std::is_signed<V>::value) u ^= U(1) << (sizeof(U) * 8 - 1);
+    append_big_endian(out, u);
+  }
+};
+
+template<> struct key_field<bool> {
+  template<class Sink> static void append(Sink& out, bool v) { out.append(v ? "\1" : "\0", 1); }
+};
+
+template<class V> struct key_field<V, typename std::enable_if<std::is_enum<V>::value>::type> {
+  typedef typename std::underlying_type<V>::type U;
+  template<class Sink> static void append(Sink& out, V v) { key_field<U>::append(out, (U)v); }
+};
+
+template<class V> struct key_field<V, typename std::enable_if<std::is_floating_point<V>::value>::type> {
+  typedef typename std::conditional<sizeof(V) == 4, unsigned int, unsigned long long>::type U;
+  static_assert(sizeof(V) == sizeof(U), "only float and double keys are supported");
+
+  template<class Sink> static void append(Sink& out, V v) {
+    if (v == 0) v = 0;
+    if (v != v) v = std::numeric_limits<V>::quiet_NaN();
+    U u;
+    std::memcpy(&u, &v, sizeof(u));
+    const U sign = U(1) << (sizeof(U) * 8 - 1);
+    append_big_endian(out, (u & sign) ? U(~u) : U(u | sign));
+  }
+};
+
+template<class Sink> inline void append_key_text(Sink& out, const char* p, const char* end) {
+  while (const char* zero = (const char*)std::memchr(p, 0, end - p)) {
+    out.append(p, zero - p);
+    out.append("\0\xff", 2);
+    p = zero + 1;
+  }
+  out.append(p, end - p);
+  out.append("\0\1", 2);
+}
+
+template<> struct key_field<std::string> {
+  template<class Sink> static void append(Sink& out, const std::string& v) { 
+    append_key_text(out, v.data(), v.data() + v.size()); 
+  }
+};
+
+#if __cpp_lib_string_view
+template<> struct key_field<std::string_view> {
+  template<class Sink> static void append(Sink& out, const std::string_view& v) { 
+    append_key_text(out, v.data(), v.data() + v.size()); 
+  }
+};
+#endif
+
+template<class Sink> inline void encode_key(Sink&, const tuple_end&) {}
+// appends the normalized key of tuple to out (anything with append(const char*, size_t))
+template<class Sink, class T> inline Sink& encode_key(Sink& out, const T& tuple) {
+  key_field<typename T::head_type>::append(out, tuple.head());
+  encode_key(out, tuple.tail());
+  return out;
+}
+
+//////////////////////// radix_sort
+
+struct sort_key {
+  const unsigned char* data;
+  std::size_t size;
+  std::size_t index;
+};
+
+// orders keys that are equal up to depth
+struct sort_key_less {
+  explicit sort_key_less(std::size_t depth): _depth(depth) {}
+  bool operator() (const sort_key& l, const sort_key& r) const {
+    std::size_t n = std::min(l.size, r.size) - _depth;
+    int c = n ? std::memcmp(l.data + _depth, r.data + _depth, n) : 0;
+    return c ? c < 0 : l.size < r.size;
+  }
+private:
+  std::size_t _depth;
+};
+
+// MSD radix sort of keys that are equal up to depth. Bucket 0 holds keys that
+// end at depth (they are all equal), buckets 1 - 256 the next byte. Small 
+// ranges are left to a comparison sort. Stable. The largest bucket is sorted
+// in the loop and only the others (at most half of the keys each) recursively,
+// so the stack stays O(log n). After radix_sort_levels bytes a comparison 
+// sort takes over as well: keys with long shared prefixes ("a", "aa", "aaa", 
+// ...) would otherwise cost a pass over the range per byte.
+
+enum { radix_sort_levels = 64 };
+
+inline void radix_sort_keys(sort_key* first, sort_key* last, sort_key* buffer, std::size_t depth, 
+  std::size_t levels = radix_sort_levels) {
+  for (;; --levels) {
+    std::size_t n = last - first;
+    if (n < 64 || !levels) {
+      std::stable_sort(first, last, sort_key_less(depth));
+      return;
+    }
+
+    std::size_t start[258] = {0};
+    for (sort_key* k = first; k != last; ++k) ++start[(k->size > depth ? k->data[depth] + 1 : 0) + 1];
+    if (start[1] == n) return;
+
+    // a byte all keys share doesn't need to be moved around
+    std::size_t bucket = 1;
+    while (bucket < 257 && !start[bucket + 1]) ++bucket;
+    if (start[bucket + 1] == n) {
+      ++depth;
+      continue;
+    }
+
+    for (int b = 1; b < 258; ++b) start[b] += start[b - 1];
+    std::size_t pos[257];
+    std::copy(start, start + 257, pos);
+    for (sort_key* k = first; k != last; ++k) buffer[pos[k->size > depth ? k->data[depth] + 1 : 0]++] = *k;
+    std::copy(buffer, buffer + n, first);
+
+    int largest = 1;
+    for (int b = 2; b < 257; ++b) {
+      if (start[b + 1] - start[b] > start[largest + 1] - start[largest]) largest = b;
+    }
+    for (int b = 1; b < 257; ++b) {
+      if (b != largest && start[b + 1] - start[b] > 1) {
+        radix_sort_keys(first + start[b], first + start[b + 1], buffer + start[b], depth + 1, levels - 1);
+      }
+    }
+    buffer += start[largest];
+    last = first + start[largest + 1];
+    first += start[largest];
+    ++depth;
+  }
+}
+
+// sorts tuples by their normalized keys: same order as std::stable_sort with 
+// operator< but without comparing element by element
+template<class It> void radix_sort(It first, It last) {
+  typedef typename std::iterator_traits<It>::value_type value_type;
+  const std::size_t n = last - first;
+  if (n < 2) return;
+
+  std::string bytes;
+  std::vector<std::size_t> offsets(n + 1);
+  It i = first;
+  for (std::size_t k = 0; k < n; ++k, ++i) {
+    offsets[k] = bytes.size();
+    encode_key(bytes, *i);
+  }
+  offsets[n] = bytes.size();
+
+  std::vector<sort_key> keys(n), buffer(n);
+  for (std::size_t k = 0; k < n; ++k) {
+    sort_key key = { (const unsigned char*)bytes.data() + offsets[k], offsets[k + 1] - offsets[k], k };
+    keys[k] = key;
+  }
+  radix_sort_keys(keys.data(), keys.data() + n, buffer.data(), 0);
+
+  std::vector<value_type> sorted;
+  sorted.reserve(n);
+  for (std::size_t k = 0; k < n; ++k) sorted.push_back(std::move(first[keys[k].index]));
+  std::move(sorted.begin(), sorted.end(), first);
+}
+
+//////////////////////// parallel_sort
+
+// sorts chunks of the range on separate threads and merges them pairwise (in
+// parallel as well). threads = 0 uses all hardware threads.
+template<class It, class Less> void parallel_sort(It first, It last, Less less, unsigned threads = 0) {
+  if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t n = last - first;
+  if (threads < 2 || n < 4096) {
+    std::sort(first, last, less);
+    return;
+  }
+
+  std::vector<It> bounds;
+  for (unsigned t = 0; t <= threads; ++t) bounds.push_back(first + n * t / threads);
+
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.push_back(std::thread([&bounds, less, t]() { std::sort(bounds[t], bounds[t + 1], less); }));
+  }
+  for (std::size_t t = 0; t < workers.size(); ++t) workers[t].join();
+
+  for (std::size_t width = 1; width < threads; width *= 2) {
+    workers.clear();
+    for (std::size_t t = 0; t + width < threads; t += 2 * width) {
+      It a = bounds[t], m = bounds[t + width], b = bounds[std::min<std::size_t>(t + 2 * width, threads)];
+      workers.push_back(std::thread([a, m, b, less]() { std::inplace_merge(a, m, b, less); }));
+    }
+    for (std::size_t t = 0; t < workers.size(); ++t) workers[t].join();
+  }
+}
+
+template<class It> void parallel_sort(It first, It last) {
+  parallel_sort(first, last, std::less<typename std::iterator_traits<It>::value_type>());
+}
+
+} // namespace tuple_details
+
+// lifting the sort functions to tbd namespace
+using tuple_details::encode_key;
+using tuple_details::radix_sort;
+using tuple_details::parallel_sort;
+
+} // namspace tbd
+
+#endif // __tuple_sort_h__
@@ -0,0 +1,89 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "tuple_sort.h"
+using tbd::accu;
+using tbd::tuple;
+
+// memcmp order of two keys, shorter is less if otherwise equal
+int compare_keys(const string& l, const string& r) {
+  int c = std::memcmp(l.data(), r.data(), std::min(l.size(), r.size()));
+  return c ? c : l.size() < r.size() ? -1 : l.size() > r.size() ? 1 : 0;
+}
+
+int sign(int c) { return c < 0 ? -1 : c > 0 ? 1 : 0; }
+
+template<class T1, class T2> void check_order(const T1& l, const T2& r) {
+  string lk, rk;
+  tbd::encode_key(lk, l);
+  tbd::encode_key(rk, r);
+  assert(sign(compare_keys(lk, rk)) == sign(tbd::compare(l, r)));
+}
+
+int main() {
+  typedef tuple<int, double, string, long long> row;
+  std::mt19937 random(7);
+  const double doubles[] = { -std::numeric_limits<double>::infinity(), -1e300, -2.5, -0.0, 0.0, 
+    std::numeric_limits<double>::denorm_min(), 1.0, 2.5, 1e300, std::numeric_limits<double>::infinity() };
+  string texts[] = { "", string("\0", 1), string("a\0b", 3), "a", "ab", "b", "\xff" };
+
+  vector<row> rows;
+  for (int i = 0; i < 20000; ++i) {
+    rows.push_back(accu << int(random() % 7) - 3 | doubles[random() % 10] | texts[random() % 7] 
+      | (long long)(random() % 5) - 2);
+  }
+
+  // keys order tuples just like compare does (prefix tuples included)
+  for (int i = 0; i < 20000; ++i) {
+    row& l = rows[random() % rows.size()];
+    row& r = rows[random() % rows.size()];
+    check_order(l, r);
+    tuple<int, double> prefix(accu << l.get<0>() | l.get<1>());
+    check_order(prefix, r);
+    check_order(r, prefix);
+  }
+  check_order(tuple<unsigned char, bool, float>(accu << (unsigned char)200 | false | -1.5f), 
+    tuple<unsigned char, bool, float>(accu << (unsigned char)200 | true | -3.0f));
+
+  // radix_sort gives the same order as std::stable_sort
+  vector<row> expected = rows, sorted = rows;
+  std::stable_sort(expected.begin(), expected.end());
+  tbd::radix_sort(sorted.begin(), sorted.end());
+  for (size_t i = 0; i < rows.size(); ++i) assert(tbd::compare(sorted[i], expected[i]) == 0);
+
+  // keys that are prefixes of each other ("a", "aa", ...) neither recurse per byte nor go quadratic
+  typedef tuple<string, int> nested;
+  vector<nested> prefixes;
+  for (int i = 0; i < 3000; ++i) prefixes.push_back(accu << string(1 + (i * 7919) % 3000, 'a') | i % 3);
+  for (int i = 0; i < 300; ++i) prefixes.push_back(accu << string(1 + i * 5, 'a') + "b" | i);
+  vector<nested> nested_expected = prefixes;
+  std::stable_sort(nested_expected.begin(), nested_expected.end());
+  tbd::radix_sort(prefixes.begin(), prefixes.end());
+  assert(prefixes == nested_expected);
+
+  // parallel_sort sorts with operator< (or any other comparison)
+  sorted = rows;
+  tbd::parallel_sort(sorted.begin(), sorted.end());
+  assert(std::is_sorted(sorted.begin(), sorted.end()));
+  sorted = rows;
+  tbd::parallel_sort(sorted.begin(), sorted.end(), std::less<row>(), 5);
+  assert(std::is_sorted(sorted.begin(), sorted.end()));
+  tbd::parallel_sort(sorted.begin(), sorted.end(), std::greater<row>(), 3);
+  assert(std::is_sorted(sorted.begin(), sorted.end(), std::greater<row>()));
+
+  cout << "sorted " << sorted.size() << " rows" << endl;
+  return 0;
+}
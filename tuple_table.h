@@ -0,0 +1,272 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+#ifndef __tuple_table_h__
+#define __tuple_table_h__
+
+#include <cstddef>
+#include <vector>
+#include "tuple.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// columns
+
+// One std::vector per element of T. Like tuple_item each level derives from 
+// the columns of its tail so (table_columns<S>&) selects the column of S.
+// Note: std::vector<bool> is not contiguous - use char for flags.
+
+template<class T> struct table_columns : public table_columns<typename T::tail_type> {
+  typedef table_columns<T> self;
+  typedef typename T::head_type value_type;
+  typedef std::vector<value_type> head_type;
+  typedef table_columns<typename T::tail_type> tail_type;
+
+  head_type& head() { return _head; }
+  tail_type& tail() { return *this; }
+  const head_type& head() const { return _head; }
+  const tail_type& tail() const { return *this; }
+
+  void reserve(std::size_t n) { _head.reserve(n); tail().reserve(n); }
+  void clear() { _head.clear(); tail().clear(); }
+  void grow() { _head.emplace_back(); tail().grow(); }
+
+  template<class HT, class TT> void push(const tuple_item<HT, TT>& t) { 
+    _head.push_back(t.head()); 
+    tail().push(t.tail()); 
+  }
+  template<class HT, class TT> void push(tuple_item<HT, TT>&& t) { 
+    _head.push_back(std::move(t.head())); 
+    tail().push(std::move(t.tail())); 
+  }
+  template<class HT, class TT> void fetch(tuple_item<HT, TT>& t, std::size_t row) const { 
+    t.head() = _head[row]; 
+    tail().fetch(t.tail(), row); 
+  }
+private:
+  head_type _head;
+};
+
+template<> struct table_columns<tuple_end> {
+  void reserve(std::size_t) {}
+  void clear() {}
+  void grow() {}
+  void push(const tuple_end&) {}
+  void fetch(tuple_end&, std::size_t) const {}
+};
+
+//////////////////////// column span
+
+template<class V> struct column_span {
+  typedef V value_type;
+  typedef V* iterator;
+  typedef const V* const_iterator;
+
+  column_span(V* data, std::size_t size): _data(data), _size(size) {}
+
+  V* data() const { return _data; }
+  std::size_t size() const { return _size; }
+  bool empty() const { return !_size; }
+  V& operator[] (std::size_t i) const { return _data[i]; }
+  V* begin() const { return _data; }
+  V* end() const { return _data + _size; }
+private:
+  V* _data;
+  std::size_t _size;
+};
+
+//////////////////////// row collector / distributor
+
+template<class T, class S = T> struct row_collector : public row_collector<T, typename S::tail_type> {
+  typedef row_collector<T, typename S::tail_type> super;
+  row_collector(table_columns<T>& c, std::size_t row): super(c, row) {}
+
+  template<class V> super& operator| (V&& v) { 
+    ((table_columns<S>&)this->_columns).head()[this->_row] = std::forward<V>(v); 
+    return *this; 
+  }
+  super& operator| (const ignore&) { return *this; }
+};
+
+template<class T> struct row_collector<T, tuple_end> {
+  row_collector(table_columns<T>& c, std::size_t row): _columns(c), _row(row) {}
+protected:
+  table_columns<T>& _columns;
+  std::size_t _row;
+};
+
+template<class T, class S = T> struct row_distributor : public row_distributor<T, typename S::tail_type> {
+  typedef row_distributor<T, typename S::tail_type> super;
+  row_distributor(table_columns<T>& c, std::size_t row): super(c, row) {}
+
+  template<class V> super& operator| (V& v) { 
+    const typename S::head_type& element = ((table_columns<S>&)this->_columns).head()[this->_row];
+    v = TBD_TUPLE_TRANSFER(const typename S::head_type&, element); 
+    return *this; 
+  }
+  super& operator| (const ignore&) { return *this; }
+};
+
+template<class T> struct row_distributor<T, tuple_end> {
+  row_distributor(table_columns<T>& c, std::size_t row): _columns(c), _row(row) {}
+protected:
+  table_columns<T>& _columns;
+  std::size_t _row;
+};
+
+//////////////////////// row accept
+
+template<class V> void row_accept(table_columns<tuple_end>&, std::size_t, V&, int) {}
+template<class HT, class TT, class V> 
+void row_accept(table_columns<tuple_item<HT, TT> >& c, std::size_t row, V& visitor, int i = 0) {
+  visitor(c.head()[row], i);
+  row_accept(c.tail(), row, visitor, i + 1);
+}
+
+template<class V> void row_accept(table_columns<tuple_end>&, std::size_t, const V&, int) {}
+template<class HT, class TT, class V> 
+void row_accept(table_columns<tuple_item<HT, TT> >& c, std::size_t row, const V& visitor, int i = 0) {
+  visitor(c.head()[row], i);
+  row_accept(c.tail(), row, visitor, i + 1);
+}
+
+//////////////////////// row
+
+// A row of a tuple_table behaves like a tuple whose elements live in the 
+// columns of the table. It stays valid as long as the table is not resized.
+
+template<class Tuple> struct table_row {
+  typedef table_row<Tuple> self;
+  typedef Tuple tuple_type;
+  typedef typename tuple_type::value_type value_type;
+  typedef table_columns<value_type> columns_type;
+
+  table_row(columns_type& c, std::size_t row): _columns(&c), _row(row) {}
+
+  template<int C> struct element { 
+    typedef typename tuple_element<C, value_type>::type::head_type type; 
+  };
+
+  template<int C> typename element<C>::type& get() const { 
+    typedef typename tuple_element<C, value_type>::type te;
+    return ((table_columns<te>&)*_columns).head()[_row];
+  }
+  template<int C> void set(const typename element<C>::type& v) const { 
+    get<C>() = v; 
+  }
+
+  template<class V> 
+  row_collector<value_type, typename value_type::tail_type> operator<< (V&& value) const {
+    return row_collector<value_type>(*_columns, _row) | std::forward<V>(value);
+  }
+
+  template<class V> 
+  row_distributor<value_type, typename value_type::tail_type> operator>> (V& value) const {
+    return row_distributor<value_type>(*_columns, _row) | value;
+  }
+
+  template<class V> V& accept(V& visitor) const { 
+    row_accept(*_columns, _row, visitor);
+    return visitor; 
+  }
+  template<class V> const V& accept(const V& visitor) const { 
+    row_accept(*_columns, _row, visitor);
+    return visitor; 
+  }
+
+  // copies the row into a real tuple (e.g. for comparison or join)
+  tuple_type value() const {
+    tuple_type t;
+    _columns->fetch(t.value(), _row);
+    return t;
+  }
+  operator tuple_type () const { return value(); }
+
+  std::size_t index() const { return _row; }
+private:
+  columns_type* _columns;
+  std::size_t _row;
+};
+
+//////////////////////// tuple_table
+
+// Stores the elements of tuple<S0, S1, ...> column by column (struct of 
+// arrays) so scanning a single element only touches that element's memory.
+
+template<class... S> 
+struct tuple_table {
+  typedef tuple_table<S...> self;
+  typedef tuple<S...> tuple_type;
+  typedef typename tuple_type::value_type value_type;
+  typedef table_row<tuple_type> row;
+  typedef table_columns<value_type> columns_type;
+
+  template<int C> struct element { 
+    typedef typename tuple_element<C, value_type>::type::head_type type; 
+  };
+
+  tuple_table(): _size(0) {}
+
+  std::size_t size() const { return _size; }
+  bool empty() const { return !_size; }
+  void reserve(std::size_t n) { _columns.reserve(n); }
+  void clear() { _columns.clear(); _size = 0; }
+
+  void push_back(const tuple_type& t) { _columns.push(t.value()); ++_size; }
+  void push_back(tuple_type&& t) { _columns.push(std::move(t.value())); ++_size; }
+
+  // appends a default row and fills it: table << 1 | "foo" | 2.5
+  template<class V> 
+  row_collector<value_type, typename value_type::tail_type> operator<< (V&& value) {
+    _columns.grow();
+    ++_size;
+    return back() << std::forward<V>(value);
+  }
+
+  row operator[] (std::size_t i) { return row(_columns, i); }
+  row front() { return row(_columns, 0); }
+  row back() { return row(_columns, _size - 1); }
+
+  template<int C> column_span<typename element<C>::type> column() {
+    typedef typename tuple_element<C, value_type>::type te;
+    std::vector<typename element<C>::type>& c = ((table_columns<te>&)_columns).head();
+    return column_span<typename element<C>::type>(c.data(), _size);
+  }
+  template<int C> column_span<const typename element<C>::type> column() const {
+    typedef typename tuple_element<C, value_type>::type te;
+    const std::vector<typename element<C>::type>& c = ((const table_columns<te>&)_columns).head();
+    return column_span<const typename element<C>::type>(c.data(), _size);
+  }
+private:
+  columns_type _columns;
+  std::size_t _size;
+};
+
+} // namespace tuple_details
+
+using tuple_details::tuple_table; // lifting tuple_table to tbd namespace
+
+} // namspace tbd
+
+#endif // __tuple_table_h__
@@ -0,0 +1,65 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+
+#include "tuple_table.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::tuple_table;
+
+struct outputter {
+  template<class V> void operator () (V& value, int i) const {
+    cout << value << " ";
+  }
+};
+
+int main() {
+  typedef tuple_table<int, string, double> users;
+  users table;
+
+  // rows are appended just like tuples are filled ...
+  table << 1 | "sally" | 47.11;
+  table << 2 | "harry";   // missing values stay default constructed
+  table.push_back(accu << 3 | "sue" | 52.5);
+  assert(table.size() == 3);
+
+  // ... and read the same way
+  int id; string name; double weight;
+  table[0] >> id | name | weight;
+  assert(id == 1 && name == "sally" && weight == 47.11);
+  table[1] >> id | name | weight;
+  assert(id == 2 && name == "harry" && weight == 0.0);
+
+  // into wider types the values are converted
+  tuple_table<int, float> narrow;
+  narrow << -1 | 0.5f;
+  long long wide; double half;
+  narrow[0] >> wide | half;
+  assert(wide == -1 && half == 0.5);
+
+  // rows can be used like tuples
+  table[1].set<2>(80.0);
+  assert(table[1].get<2>() == 80.0);
+  table[2].accept(outputter());
+  cout << endl;
+
+  tuple<int, string, double> sue = table[2];
+  assert(sue == table.back().value());
+  cout << table[0].value().join(", ") << endl;
+
+  // each element lives in its own contiguous column
+  double sum = 0;
+  for (double w : table.column<2>()) sum += w;
+  assert(sum == 47.11 + 80.0 + 52.5);
+  assert(table.column<0>().size() == 3 && &table.column<0>()[2] == table.column<0>().data() + 2);
+
+  table.clear();
+  assert(table.empty() && table.column<1>().empty());
+
+  return 0;
+}
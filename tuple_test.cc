@@ -8,7 +8,15 @@ using std::string;
 #include <deque>
 using std::deque;
 
-#include "../tuple/tuple.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <thread>
+
+#include "tuple.h"
 using tbd::accu;
 using tbd::tuple;
 
@@ -21,6 +29,273 @@ struct outputter {
   }
 };
 
+// counts how often it gets copied or moved
+struct counted {
+  static int copies, moves;
+  string value;
+
+  counted(const char* v = ""): value(v) {}
+  counted(const counted& other): value(other.value) { ++copies; }
+  counted(counted&& other): value(std::move(other.value)) { ++moves; }
+  counted& operator= (const counted& other) { value = other.value; ++copies; return *this; }
+  counted& operator= (counted&& other) { value = std::move(other.value); ++moves; return *this; }
+
+  static void reset() { copies = moves = 0; }
+};
+int counted::copies = 0;
+int counted::moves = 0;
+
+// building a tuple with accu copies lvalues and moves rvalues - exactly once
+void count_copies() {
+  typedef tuple<counted, counted, counted, counted, counted, 
+    counted, counted, counted, counted, counted> row;
+
+  counted a("a"), b("b"), c("c"), d("d"), e("e"), f("f"), g("g"), h("h"), i("i"), j("j");
+
+  counted::reset();
+  row copied(accu << a | b | c | d | e | f | g | h | i | j);
+  assert(counted::copies == 10 && counted::moves == 0);
+  assert(copied.get<0>().value == "a" && copied.get<9>().value == "j");
+
+  counted::reset();
+  row moved(accu << counted("0") | counted("1") | counted("2") | counted("3") | counted("4") 
+    | counted("5") | counted("6") | counted("7") | counted("8") | counted("9"));
+  assert(counted::copies == 0 && counted::moves == 10);
+  assert(moved.get<0>().value == "0" && moved.get<9>().value == "9");
+
+  counted::reset();
+  row mixed(accu << std::move(a) | b | std::move(c) | d | std::move(e) 
+    | f | std::move(g) | h | std::move(i) | j);
+  assert(counted::copies == 5 && counted::moves == 5);
+  assert(a.value.empty() && b.value == "b");
+}
+
+// a builder needs exactly one value per element, anything else does not compile:
+// g++ -DTUPLE_TEST_TOO_MANY_VALUES or -DTUPLE_TEST_TOO_FEW_VALUES fails with
+// "accu << ... needs one value per element"
+void build_sizes() {
+  tuple<int, int> exact = accu << 1 | 2;
+  assert(exact.get<0>() == 1 && exact.get<1>() == 2);
+#ifdef TUPLE_TEST_TOO_MANY_VALUES
+  tuple<int, int> too_many = accu << 1 | 2 | 3;
+#endif
+#ifdef TUPLE_TEST_TOO_FEW_VALUES
+  tuple<int, int, int> too_few = accu << 1 | 2;
+#endif
+}
+
+// comparison is lexicographic, a shorter tuple is less than a longer one
+void compare_tuples() {
+  tuple<string, int, double> a(accu << "bob" | 1 | 2.5), b(accu << "bob" | 1 | 3.5);
+  tuple<string, int> prefix(accu << "bob" | 1);
+
+  assert(tbd::compare(a, b) < 0 && tbd::compare(b, a) > 0 && tbd::compare(a, a) == 0);
+  assert(a < b && a <= b && b > a && b >= a && a != b && !(a == b));
+  assert(a <= a && a >= a && !(a < a) && !(a > a));
+
+  assert(tbd::compare(prefix, a) < 0 && tbd::compare(a, prefix) > 0);
+  assert(prefix < a && prefix <= a && a > prefix && a >= prefix && prefix != a);
+
+  tuple<string, int> alice(accu << "alice" | 9);
+  assert(alice < prefix && !(prefix <= alice));
+}
+
+// runtime indexed access has no lazily built state, several threads may
+// use it for the first time at once (run with -fsanitize=thread)
+void concurrent_get() {
+  typedef tuple<long, float, string, double> row;
+  row r(accu << 1L | 2.5f | "3" | 4.25);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.push_back(std::thread([r]() mutable {
+      for (int n = 0; n < 1000; ++n) {
+        double sum = 0;
+        for (int i = 0; i < row::size; ++i) sum += r.get<double>(i);
+        assert(sum == 10.75);
+        assert(*r.begin<long>() == 1L);
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+}
+
+// runtime conversions between numbers and strings
+void convert_values() {
+  tuple<int, string, double, float, string> x(accu << 12 | "34.56" | 0.1 + 0.2 | 2.5f | " +7 apples");
+
+  assert(x.get<int>(0) == 12 && x.get<int>(1) == 34 && x.get<int>(2) == 0 && x.get<int>(4) == 7);
+  assert(x.get<double>(1) == 34.56 && x.get<double>(3) == 2.5);
+  assert(x.get<string>(0) == "12" && x.get<string>(3) == "2.5");
+
+#if TBD_TUPLE_HAS_CHARCONV
+  // doubles are written with all the digits they need to read back the same
+  assert(x.get<string>(2) == "0.30000000000000004");
+  tuple<string> text(accu << x.get<string>(2));
+  assert(text.get<double>(0) == x.get<2>());
+#endif
+
+  // values that can't be read give a default value
+  tuple<string> nothing(accu << "apples");
+  assert(nothing.get<int>(0) == 0 && nothing.get<double>(0) == 0.0);
+}
+
+// begin<V>() converts lazily, tuples of V only are iterated by reference
+void iterate_elements() {
+  typedef tuple<double, double, double, double> doubles;
+  doubles d(accu << 4.0 | 1.0 | 3.0 | 2.0);
+  typedef doubles::value_type items;
+  static_assert(std::is_same<tbd::tuple_details::element_iterator<items, double>::reference, double&>::value, "");
+  static_assert(std::is_same<tbd::tuple_details::element_iterator<const items, double>::reference, const double&>::value, "");
+  static_assert(std::is_same<std::iterator_traits<tbd::tuple_details::element_iterator<items, double> >::iterator_category, 
+    std::random_access_iterator_tag>::value, "");
+  // converted values are no references, so the standard library sees an input iterator
+  static_assert(std::is_same<std::iterator_traits<tbd::tuple_details::element_iterator<items, int> >::iterator_category, 
+    std::input_iterator_tag>::value, "");
+
+  assert(&*d.begin<double>() == &d.get<0>() && &d.begin<double>()[3] == &d.get<3>());
+  assert(d.end<double>() - d.begin<double>() == 4);
+  std::sort(d.begin<double>(), d.end<double>());
+  assert(d == doubles(accu << 1.0 | 2.0 | 3.0 | 4.0));
+  *(d.begin<double>() + 3) = 5.0;
+  assert(d.get<3>() == 5.0 && std::accumulate(d.begin<double>(), d.end<double>(), 0.0) == 11.0);
+
+  const doubles& c = d;
+  tbd::tuple_details::element_iterator<const items, double> i = d.begin<double>();
+  assert(i == c.begin<double>() && &*i == &d.get<0>() && i < c.end<double>());
+  assert(std::lower_bound(c.begin<double>(), c.end<double>(), 4.0) - c.begin<double>() == 3);
+
+  // mixed tuples yield converted values, one conversion per dereference
+  tuple<int, string, double> m(accu << 1 | "2.5" | 3.25);
+  std::vector<double> values(m.begin<double>(), m.end<double>());
+  assert(values.size() == 3 && values[1] == 2.5 && values[2] == 3.25);
+  assert(m.begin<string>()[2] == "3.25" && m.begin<string>()->size() == 1);
+  std::vector<int> ints;
+  std::copy(m.begin<int>(), m.end<int>(), std::back_inserter(ints));
+  assert(ints.size() == 3 && ints[0] == 1 && ints[1] == 2 && ints[2] == 3);
+  assert(*(m.end<int>() - 1) == 3 && m.end<int>() - m.begin<int>() == 3);
+}
+
+// join appends to strings or fixed size buffers
+void join_tuples() {
+  tuple<int, string, double, bool> t(accu << 42 | "sally" | 47.11 | true);
+  assert(t.join(", ") == "42, sally, 47.11, 1");
+
+  string line = "> ";
+  t.join_to(line, ";");
+  assert(line == "> 42;sally;47.11;1");
+
+  char buffer[32];
+  char* end = t.join_to(buffer, sizeof(buffer), "|");
+  assert(end && string(buffer, end) == "42|sally|47.11|1");
+  assert(!t.join_to(buffer, 8, "|"));
+
+  tbd::field_format formats[] = { tbd::field_format('x'), tbd::field_format(), 
+    tbd::field_format('f', 1), tbd::field_format() };
+  assert(t.join(", ") == t.join_to(line.erase(), ", "));
+  assert(t.join_to(line.erase(), ",", formats) == "2a,sally,47.1,1");
+}
+
+// there is no upper limit for the number of elements
+typedef tuple<int, double, string, long, int, double, string, long, int, double, string,
+  long, int, double, string, long, int, double, string, long, int, double, string, long,
+  int, double, string, long, int, double, string, long, int, double, string, long, int,
+  double, string, long> wide;
+
+void wide_tuples() {
+  wide w(accu << 0 | 1.5 | "s2" | 3L | 4 | 5.5 | "s6" | 7L | 8 | 9.5 | "s10" | 11L | 12
+    | 13.5 | "s14" | 15L | 16 | 17.5 | "s18" | 19L | 20 | 21.5 | "s22" | 23L | 24 | 25.5
+    | "s26" | 27L | 28 | 29.5 | "s30" | 31L | 32 | 33.5 | "s34" | 35L | 36 | 37.5 | "s38"
+    | 39L);
+  assert(w.get<0>() == 0 && w.get<38>() == "s38" && w.get<39>() == 39L);
+  assert(w.get<string>(37) == "37.5" && tbd::tuple_details::last_element<wide::value_type>::type::size == 1);
+
+  int first;
+  double second;
+  w >> first | second;
+  assert(first == 0 && second == 1.5);
+
+  wide copy(w);
+  copy.set<39>(40L);
+  assert(w < copy && w != copy && w == wide(w));
+  assert(w.join(",").size() > 80);
+}
+
+// tuples of plain values are trivially copyable, arrays of them are copied as bytes
+typedef tuple<int, int, double> pod;
+static_assert(tbd::is_pod_tuple<pod>::value, "tuple of numbers must be trivially copyable");
+static_assert(std::is_trivially_copyable<tuple<char, float, const char*, long long> >::value, "");
+static_assert(std::is_trivially_destructible<pod>::value, "");
+static_assert(!tbd::is_pod_tuple<tuple<int, string> >::value, "strings are not");
+static_assert(!std::is_standard_layout<pod>::value, "every tuple_item holds an element");
+static_assert(std::is_standard_layout<tuple<int> >::value, "");
+
+void copy_pods() {
+  pod rows[4] = { accu << 1 | 2 | 0.5, accu << 3 | 4 | 1.5, accu << 5 | 6 | 2.5, accu << 7 | 8 | 3.5 };
+  pod copies[4];
+  assert(tbd::tuple_copy(rows, rows + 4, copies) == copies + 4);
+  assert(copies[3] == rows[3] && copies[0] == rows[0]);
+
+  pod bytes;
+  std::memcpy((void*)&bytes, (const void*)&rows[1], sizeof(pod));
+  assert(bytes.get<0>() == 3 && bytes.get<2>() == 1.5);
+
+  tbd::tuple_relocate(rows + 1, rows + 4, rows);           // overlapping
+  assert(rows[0] == copies[1] && rows[2] == copies[3]);
+
+  // others are copied element by element and moved on relocate
+  tuple<int, string> strings[3] = { accu << 1 | "one", accu << 2 | "two", accu << 3 | "three" };
+  tuple<int, string> assigned[3];
+  tbd::tuple_copy(strings, strings + 3, assigned);
+  assert(assigned[2] == strings[2]);
+
+  typedef tuple<int, string> row;
+  alignas(row) unsigned char raw[4 * sizeof(row)];
+  row* rs = new (raw) row[3];
+  tbd::tuple_copy(strings, strings + 3, rs);
+  tbd::tuple_relocate(rs, rs + 3, rs + 1);                 // overlapping, backwards
+  assert(rs[1] == strings[0] && rs[3] == strings[2]);
+  for (int i = 1; i < 4; ++i) rs[i].~row();
+}
+
+// tables of tuples are built by the compiler (no dynamic initialization)
+typedef tuple<int, int, double> entry;
+constexpr entry table[] = { accu << 1 | 10 | 0.5, accu << 3 | 30 | 1.5, accu << 5 | 50 | 2.5, accu << 7 | 70 | 3.5 };
+
+// index of the first entry not less than key
+constexpr int lower_bound(const entry* t, int first, int last, const entry& key) {
+  return first == last ? first : t[(first + last) / 2] < key 
+    ? lower_bound(t, (first + last) / 2 + 1, last, key) 
+    : lower_bound(t, first, (first + last) / 2, key);
+}
+
+static_assert(table[2].get<1>() == 50 && table[3].get<2>() == 3.5, "");
+static_assert(table[0] < table[1] && table[1] == entry(accu << 3 | 30 | 1.5), "");
+static_assert(tbd::compare(table[2], table[1]) > 0 && table[3] != table[2], "");
+static_assert(lower_bound(table, 0, 4, accu << 5 | 50 | 0.0) == 2, "");
+static_assert(lower_bound(table, 0, 4, accu << 9 | 0 | 0.0) == 4, "");
+
+#if __cpp_constexpr >= 201304L
+// C++14: set, << and accept too
+struct summer {
+  double sum = 0;
+  template<class V> constexpr void operator() (const V& v, int) { sum += v; }
+};
+constexpr double row_sum(const entry& e) {
+  summer s;
+  e.accept(s);
+  return s.sum;
+}
+constexpr entry filled() {
+  entry e{};
+  e << 1 | 2 | 3.5;
+  e.set<1>(4);
+  return e;
+}
+static_assert(row_sum(table[1]) == 34.5, "");
+static_assert(filled().get<1>() == 4 && filled().get<2>() == 3.5 && row_sum(filled()) == 8.5, "");
+#endif
+
 tuple<int, int> divmod(int dividend, int divisor) {
   return accu << dividend / divisor | dividend % divisor;
 }
@@ -36,6 +311,16 @@ tuple<int, int, int> hms(int seconds) {
 }
 
 int main() {
+  count_copies();
+  build_sizes();
+  compare_tuples();
+  concurrent_get();
+  convert_values();
+  iterate_elements();
+  join_tuples();
+  copy_pods();
+  wide_tuples();
+
   typedef tuple<int, string, double> mytuple;
 
   tuple<double> double_tuple;
@@ -54,7 +339,7 @@ int main() {
   // both tuples and rows can be feed with plain values...
   testt << 42 | "foo" | 47.11;
 
-  tuple<__int64, string, double> t = testt;
+  tuple<long long, string, double> t = testt;
 
   cout << t.first() << " " << t.last() << endl;
 
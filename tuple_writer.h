@@ -0,0 +1,100 @@
+/* The MIT License
+
+Copyright (c) 2007 Simon Kroeger (simonkroeger@gmx.de)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+
+#ifndef __tuple_writer_h__
+#define __tuple_writer_h__
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "tuple.h"
+
+namespace tbd {
+namespace tuple_details {
+
+//////////////////////// text_writer
+
+// Buffered writer for delimited text. Tuples are formatted straight into the
+// buffer which is written to the file descriptor whenever it is full (and on
+// flush / destruction). The descriptor is not closed.
+
+struct text_writer {
+  explicit text_writer(int fd, std::size_t capacity = 1 << 16): 
+    _fd(fd), _buffer(capacity ? capacity : 1), _size(0), _good(true) {}
+  ~text_writer() { flush(); }
+
+  text_writer& append(const char* s, std::size_t n) {
+    if (n > _buffer.size() - _size) {
+      flush();
+      if (n > _buffer.size()) { write_all(s, n); return *this; }
+    }
+    std::memcpy(&_buffer[_size], s, n);
+    _size += n;
+    return *this;
+  }
+
+  // writes one row: the elements separated by separator followed by eol
+  template<class T> text_writer& write(const T& tuple, const char* separator = "", 
+    const field_format* formats = 0, char eol = '\n') {
+    tuple.join_to(*this, separator, formats);
+    return append(&eol, 1);
+  }
+
+  bool flush() {
+    write_all(_buffer.data(), _size);
+    _size = 0;
+    return _good;
+  }
+
+  // false once a write failed
+  bool good() const { return _good; }
+private:
+  void write_all(const char* s, std::size_t n) {
+    while (_good && n) {
+      ssize_t written = ::write(_fd, s, n);
+      if (written < 0) {
+        if (errno != EINTR) _good = false;
+        continue;
+      }
+      s += written;
+      n -= written;
+    }
+  }
+
+  text_writer(const text_writer&); // no copies
+  text_writer& operator= (const text_writer&);
+
+  int _fd;
+  std::vector<char> _buffer;
+  std::size_t _size;
+  bool _good;
+};
+
+} // namespace tuple_details
+
+using tuple_details::text_writer; // lifting text_writer to tbd namespace
+
+} // namspace tbd
+
+#endif // __tuple_writer_h__
@@ -0,0 +1,56 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "tuple_writer.h"
+using tbd::accu;
+using tbd::tuple;
+using tbd::text_writer;
+
+// reads the whole file behind fd
+string read_all(int fd) {
+  string text;
+  char buffer[256];
+  lseek(fd, 0, SEEK_SET);
+  for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0; ) text.append(buffer, n);
+  return text;
+}
+
+int main() {
+  char name[] = "/tmp/tuple_writer_test_XXXXXX";
+  int fd = mkstemp(name);
+  assert(fd >= 0);
+  unlink(name);
+
+  tuple<int, string, double> user(accu << 42 | "sally" | 47.11);
+  tbd::field_format formats[] = { tbd::field_format(), tbd::field_format(), tbd::field_format('f', 3) };
+
+  {
+    // a tiny buffer forces flushes in between (and a direct write for long rows)
+    text_writer out(fd, 8);
+    out.write(user, ",");
+    out.write(user, "\t", formats);
+    out.append("end", 3);
+    assert(out.flush() && out.good());
+  }
+
+  string text = read_all(fd);
+  cout << text << endl;
+  assert(text == "42,sally,47.11\n42\tsally\t47.110\nend");
+
+  // failed writes are reported by good()
+  text_writer broken(-1);
+  broken.write(user, ",");
+  assert(!broken.flush() && !broken.good());
+
+  close(fd);
+  return 0;
+}